@@ -17,20 +17,39 @@
 */
 
 #include "stdafx.h"
+#ifndef ML_CORE_ONLY
 #include "mlMainWindow.h"
+#endif
 
 int main(int argc, char *argv[])
 {
-	QApplication App(argc, argv);
+	if (mlCommandLine::IsStubTool(argc, argv))
+		return mlCommandLine::RunStubTool(argc, argv);
 
 	QCoreApplication::setOrganizationDomain("treyarch.com");
 	QCoreApplication::setOrganizationName("Treyarch");
 	QCoreApplication::setApplicationName("ModLauncher");
 //	QCoreApplication::setApplicationVersion();
 
-	mlMainWindow MainWindow;
-	MainWindow.UpdateDB();
-	MainWindow.show();
+#ifndef ML_CORE_ONLY
+	if (!mlCommandLine::IsCommandLineMode(argc, argv))
+	{
+		QApplication App(argc, argv);
 
-	return App.exec();
+		mlMainWindow MainWindow;
+		MainWindow.UpdateDB();
+		MainWindow.show();
+
+		return App.exec();
+	}
+#endif
+
+	if (mlCommandLine::NeedsWidgets(argc, argv))
+	{
+		QApplication App(argc, argv);
+		return mlCommandLine::Run(App.arguments());
+	}
+
+	QCoreApplication App(argc, argv);
+	return mlCommandLine::Run(App.arguments());
 }
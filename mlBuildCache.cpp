@@ -0,0 +1,477 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "stdafx.h"
+
+mlBuildManifest::mlBuildManifest(const QString& FileName, const QString& GamePath, const QString& ToolsPath)
+	: mFileName(FileName), mGamePath(QDir::cleanPath(QDir::fromNativeSeparators(GamePath))), mToolsPath(QDir::cleanPath(QDir::fromNativeSeparators(ToolsPath))), mDirty(false)
+{
+}
+
+QString mlBuildManifest::DefaultFileName(const QString& ToolsPath)
+{
+	return QString("%1/share/modlauncher/build_manifest.json").arg(ToolsPath);
+}
+
+bool mlBuildManifest::Load()
+{
+	QFile File(mFileName);
+	if (!File.open(QIODevice::ReadOnly))
+		return false;
+
+	QJsonObject Root = QJsonDocument::fromJson(File.readAll()).object();
+
+	QJsonObject Files = Root["Files"].toObject();
+	for (QJsonObject::const_iterator It = Files.constBegin(); It != Files.constEnd(); ++It)
+	{
+		QJsonObject FileObject = It.value().toObject();
+
+		mlFileEntry Entry;
+		Entry.Size = (qint64)FileObject["Size"].toDouble();
+		Entry.Modified = (qint64)FileObject["Modified"].toDouble();
+		Entry.Hash = FileObject["Hash"].toString().toLatin1();
+		mFiles.insert(It.key(), Entry);
+	}
+
+	QJsonObject Steps = Root["Steps"].toObject();
+	for (QJsonObject::const_iterator It = Steps.constBegin(); It != Steps.constEnd(); ++It)
+		mSteps.insert(It.key(), It.value().toString().toLatin1());
+
+	mDirty = false;
+	return true;
+}
+
+bool mlBuildManifest::Save()
+{
+	if (!mDirty)
+		return true;
+
+	QJsonObject Files;
+	for (QHash<QString, mlFileEntry>::const_iterator It = mFiles.constBegin(); It != mFiles.constEnd(); ++It)
+	{
+		QJsonObject FileObject;
+		FileObject["Size"] = (double)It->Size;
+		FileObject["Modified"] = (double)It->Modified;
+		FileObject["Hash"] = QString::fromLatin1(It->Hash);
+		Files[It.key()] = FileObject;
+	}
+
+	QJsonObject Steps;
+	for (QHash<QString, QByteArray>::const_iterator It = mSteps.constBegin(); It != mSteps.constEnd(); ++It)
+		Steps[It.key()] = QString::fromLatin1(It.value());
+
+	QJsonObject Root;
+	Root["Files"] = Files;
+	Root["Steps"] = Steps;
+
+	QDir().mkpath(QFileInfo(mFileName).absolutePath());
+
+	// Written atomically, several launchers may be building with the same tools install
+	QSaveFile File(mFileName);
+	if (!File.open(QIODevice::WriteOnly))
+		return false;
+
+	File.write(QJsonDocument(Root).toJson(QJsonDocument::Compact));
+	if (!File.commit())
+		return false;
+
+	mDirty = false;
+	return true;
+}
+
+QByteArray mlBuildManifest::HashFile(const QString& FileName)
+{
+	QFileInfo FileInfo(FileName);
+	if (!FileInfo.isFile())
+		return QByteArray();
+
+	// Files are only read again when their size or modification time changed since they were last hashed
+	QString Path = FileInfo.absoluteFilePath();
+	qint64 Modified = FileInfo.lastModified().toMSecsSinceEpoch();
+
+	QHash<QString, mlFileEntry>::const_iterator It = mFiles.constFind(Path);
+	if (It != mFiles.constEnd() && It->Size == FileInfo.size() && It->Modified == Modified)
+		return It->Hash;
+
+	QFile File(Path);
+	if (!File.open(QIODevice::ReadOnly))
+		return QByteArray();
+
+	QCryptographicHash Hash(QCryptographicHash::Sha1);
+	Hash.addData(&File);
+
+	mlFileEntry Entry;
+	Entry.Size = FileInfo.size();
+	Entry.Modified = Modified;
+	Entry.Hash = Hash.result().toHex();
+
+	mFiles.insert(Path, Entry);
+	mDirty = true;
+
+	return Entry.Hash;
+}
+
+QByteArray mlBuildManifest::StepKey(const mlBuildStep& Step, const QList<QByteArray>& DependencyKeys)
+{
+	QCryptographicHash Hash(QCryptographicHash::Sha1);
+
+	Hash.addData(NormalizePath(Step.Executable).toUtf8());
+	Hash.addData(HashFile(Step.Executable));
+
+	for (const QString& Argument : Step.Arguments)
+	{
+		Hash.addData("\0", 1);
+		Hash.addData(NormalizePath(Argument).toUtf8());
+	}
+
+	for (const QString& FileName : ExpandFiles(Step.Inputs, Step.Outputs))
+	{
+		Hash.addData("\0", 1);
+		Hash.addData(NormalizePath(FileName).toUtf8());
+		Hash.addData(HashFile(FileName));
+	}
+
+	for (const QByteArray& DependencyKey : DependencyKeys)
+	{
+		Hash.addData("\0", 1);
+		Hash.addData(DependencyKey);
+	}
+
+	return Hash.result().toHex();
+}
+
+bool mlBuildManifest::IsUpToDate(const mlBuildStep& Step, const QByteArray& Key) const
+{
+	if (Key.isEmpty() || mSteps.value(Step.Name) != Key)
+		return false;
+
+	for (const QString& Output : Step.Outputs)
+	{
+		QFileInfo OutputInfo(Output);
+		if (OutputInfo.isDir() ? QDir(Output).entryList(QDir::Files | QDir::NoDotAndDotDot).isEmpty() : !OutputInfo.isFile())
+			return false;
+	}
+
+	return true;
+}
+
+void mlBuildManifest::SetStepKey(const QString& StepName, const QByteArray& Key)
+{
+	mSteps.insert(StepName, Key);
+	mDirty = true;
+}
+
+void mlBuildManifest::RemoveStep(const QString& StepName)
+{
+	if (mSteps.remove(StepName))
+		mDirty = true;
+}
+
+// Keys only use paths relative to the game and tools folders so they don't depend on where the game is installed
+QString mlBuildManifest::NormalizePath(const QString& Path) const
+{
+	QString Result = QDir::fromNativeSeparators(Path);
+
+	if (!mGamePath.isEmpty() && Result.startsWith(mGamePath + '/', Qt::CaseInsensitive))
+		return "$GAME" + Result.mid(mGamePath.length());
+
+	if (!mToolsPath.isEmpty() && Result.startsWith(mToolsPath + '/', Qt::CaseInsensitive))
+		return "$TOOLS" + Result.mid(mToolsPath.length());
+
+	return Result;
+}
+
+QString mlBuildManifest::DenormalizePath(const QString& Path) const
+{
+	if (Path.startsWith("$GAME/"))
+		return mGamePath + Path.mid(5);
+
+	if (Path.startsWith("$TOOLS/"))
+		return mToolsPath + Path.mid(6);
+
+	return Path;
+}
+
+// Expands directories into the files they contain, a wildcard in the last path component only keeps the matching files
+QStringList mlBuildManifest::ExpandFiles(const QStringList& Paths, const QStringList& ExcludedPaths)
+{
+	QStringList Result;
+
+	QStringList Excluded;
+	for (const QString& ExcludedPath : ExcludedPaths)
+		Excluded << QDir::cleanPath(QDir::fromNativeSeparators(ExcludedPath));
+
+	auto IsExcluded = [&](const QString& FileName) -> bool
+	{
+		for (const QString& ExcludedPath : Excluded)
+			if (FileName.compare(ExcludedPath, Qt::CaseInsensitive) == 0 || FileName.startsWith(ExcludedPath + '/', Qt::CaseInsensitive))
+				return true;
+
+		return false;
+	};
+
+	for (const QString& Path : Paths)
+	{
+		QString CleanPath = QDir::cleanPath(QDir::fromNativeSeparators(Path));
+		QFileInfo PathInfo(CleanPath);
+		QStringList NameFilters;
+		QString Folder;
+
+		if (PathInfo.fileName().contains('*'))
+		{
+			NameFilters << PathInfo.fileName();
+			Folder = PathInfo.path();
+		}
+		else if (PathInfo.isDir())
+			Folder = CleanPath;
+
+		if (Folder.isEmpty())
+		{
+			if (!IsExcluded(CleanPath))
+				Result << CleanPath;
+			continue;
+		}
+
+		QDirIterator It(Folder, NameFilters, QDir::Files, QDirIterator::Subdirectories);
+		while (It.hasNext())
+		{
+			QString FileName = It.next();
+			if (!IsExcluded(FileName))
+				Result << FileName;
+		}
+	}
+
+	Result.sort(Qt::CaseInsensitive);
+	Result.removeDuplicates();
+	return Result;
+}
+
+mlArtifactCache::mlArtifactCache(const QString& CacheDir, qint64 MaxSize)
+	: mCacheDir(QDir::cleanPath(QDir::fromNativeSeparators(CacheDir))), mMaxSize(MaxSize)
+{
+}
+
+QString mlArtifactCache::EntryPath(const QByteArray& Key) const
+{
+	return QString("%1/%2/%3").arg(mCacheDir, QString::fromLatin1(Key.left(2)), QString::fromLatin1(Key));
+}
+
+bool mlArtifactCache::Contains(const QByteArray& Key) const
+{
+	return IsEnabled() && !Key.isEmpty() && QFileInfo(EntryPath(Key) + "/files.json").isFile();
+}
+
+// Copies the files of an entry next to where the step wrote them and only renames them into place once every copy
+// succeeded, so a failed restore leaves the old outputs alone. The entry's "used" file is touched for the LRU eviction.
+bool mlArtifactCache::Restore(const QByteArray& Key, const mlBuildManifest& Manifest)
+{
+	if (!IsEnabled() || Key.isEmpty())
+		return false;
+
+	QString EntryDir = EntryPath(Key);
+	QFile IndexFile(EntryDir + "/files.json");
+	if (!IndexFile.open(QIODevice::ReadOnly))
+		return false;
+
+	QJsonArray Files = QJsonDocument::fromJson(IndexFile.readAll()).object()["Files"].toArray();
+	if (Files.isEmpty())
+		return false;
+
+	QStringList FileNames, TempFileNames;
+
+	for (int FileIdx = 0; FileIdx < Files.count(); FileIdx++)
+	{
+		QString FileName = Manifest.DenormalizePath(Files[FileIdx].toObject()["Path"].toString());
+		QString TempFileName = QString("%1.restore%2").arg(FileName).arg(QCoreApplication::applicationPid());
+		QDir().mkpath(QFileInfo(FileName).absolutePath());
+
+		QFile::remove(TempFileName);
+		if (!QFile::copy(QString("%1/data/%2").arg(EntryDir).arg(FileIdx), TempFileName))
+		{
+			for (const QString& CopiedFileName : TempFileNames)
+				QFile::remove(CopiedFileName);
+			return false;
+		}
+
+		FileNames << FileName;
+		TempFileNames << TempFileName;
+	}
+
+	bool Success = true;
+
+	for (int FileIdx = 0; FileIdx < FileNames.count(); FileIdx++)
+	{
+		QFile::remove(FileNames[FileIdx]);
+		if (!QFile::rename(TempFileNames[FileIdx], FileNames[FileIdx]))
+		{
+			QFile::remove(TempFileNames[FileIdx]);
+			Success = false;
+		}
+	}
+
+	if (!Success)
+		return false;
+
+	QFile UsedFile(EntryDir + "/used");
+	if (UsedFile.open(QIODevice::WriteOnly))
+		UsedFile.write(QDateTime::currentDateTime().toString(Qt::ISODate).toLatin1());
+
+	return true;
+}
+
+mlOutputSnapshot mlArtifactCache::Snapshot(const mlBuildStep& Step)
+{
+	mlOutputSnapshot Result;
+
+	for (const QString& FileName : mlBuildManifest::ExpandFiles(Step.Outputs))
+	{
+		QFileInfo FileInfo(FileName);
+		Result.insert(FileName, qMakePair(FileInfo.size(), FileInfo.lastModified().toMSecsSinceEpoch()));
+	}
+
+	return Result;
+}
+
+// Stores the outputs the step added or changed compared to the snapshot taken before it ran, other steps may have left
+// their files in the same folder. Entries are assembled in a temporary folder and renamed into place, so other launchers
+// sharing the cache never see a partial entry.
+bool mlArtifactCache::Store(const QByteArray& Key, const mlBuildStep& Step, const mlOutputSnapshot& Before, const mlBuildManifest& Manifest)
+{
+	if (!IsEnabled() || Key.isEmpty() || Step.Outputs.isEmpty())
+		return false;
+
+	QString EntryDir = EntryPath(Key);
+	if (QFileInfo(EntryDir).isDir())
+		return true;
+
+	mlOutputSnapshot After = Snapshot(Step);
+	QStringList Files;
+
+	for (mlOutputSnapshot::const_iterator It = After.constBegin(); It != After.constEnd(); ++It)
+	{
+		if (Before.value(It.key(), qMakePair((qint64)-1, (qint64)-1)) == It.value())
+			continue;
+
+		const QString& FileName = It.key();
+
+		// Only files inside the game or tools folder can be restored into another checkout
+		if (!Manifest.NormalizePath(FileName).startsWith('$'))
+			return false;
+
+		Files << FileName;
+	}
+
+	Files.sort(Qt::CaseInsensitive);
+	if (Files.isEmpty())
+		return false;
+
+	QString TempDir = QString("%1/tmp/%2_%3").arg(mCacheDir, QString::fromLatin1(Key)).arg(QCoreApplication::applicationPid());
+	QDir(TempDir).removeRecursively();
+	if (!QDir().mkpath(TempDir + "/data"))
+		return false;
+
+	QJsonArray Entries;
+	qint64 TotalSize = 0;
+
+	for (int FileIdx = 0; FileIdx < Files.count(); FileIdx++)
+	{
+		if (!QFile::copy(Files[FileIdx], QString("%1/data/%2").arg(TempDir).arg(FileIdx)))
+		{
+			QDir(TempDir).removeRecursively();
+			return false;
+		}
+
+		QJsonObject Entry;
+		Entry["Path"] = Manifest.NormalizePath(Files[FileIdx]);
+		Entries.append(Entry);
+		TotalSize += QFileInfo(Files[FileIdx]).size();
+	}
+
+	QJsonObject Root;
+	Root["Step"] = Step.Name;
+	Root["Size"] = (double)TotalSize;
+	Root["Files"] = Entries;
+
+	QFile IndexFile(TempDir + "/files.json");
+	if (!IndexFile.open(QIODevice::WriteOnly))
+	{
+		QDir(TempDir).removeRecursively();
+		return false;
+	}
+
+	IndexFile.write(QJsonDocument(Root).toJson());
+	IndexFile.close();
+
+	QFile UsedFile(TempDir + "/used");
+	if (UsedFile.open(QIODevice::WriteOnly))
+		UsedFile.close();
+
+	QDir().mkpath(QFileInfo(EntryDir).absolutePath());
+	if (!QDir().rename(TempDir, EntryDir))
+		QDir(TempDir).removeRecursively();
+
+	return true;
+}
+
+// Removes the least recently used entries until the cache fits in its size limit
+void mlArtifactCache::Evict()
+{
+	if (!IsEnabled() || mMaxSize <= 0)
+		return;
+
+	struct mlCacheEntry
+	{
+		QString Path;
+		qint64 Size;
+		QDateTime LastUsed;
+	};
+
+	QVector<mlCacheEntry> Entries;
+	qint64 TotalSize = 0;
+
+	QDir CacheDir(mCacheDir);
+	for (const QString& Prefix : CacheDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+	{
+		if (Prefix == "tmp")
+			continue;
+
+		QDir PrefixDir(CacheDir.filePath(Prefix));
+		for (const QString& Key : PrefixDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+		{
+			mlCacheEntry Entry;
+			Entry.Path = PrefixDir.filePath(Key);
+
+			QFile IndexFile(Entry.Path + "/files.json");
+			if (!IndexFile.open(QIODevice::ReadOnly))
+				continue;
+
+			Entry.Size = (qint64)QJsonDocument::fromJson(IndexFile.readAll()).object()["Size"].toDouble();
+			Entry.LastUsed = QFileInfo(Entry.Path + "/used").lastModified();
+			Entries.append(Entry);
+			TotalSize += Entry.Size;
+		}
+	}
+
+	std::sort(Entries.begin(), Entries.end(), [](const mlCacheEntry& A, const mlCacheEntry& B) { return A.LastUsed < B.LastUsed; });
+
+	for (int EntryIdx = 0; EntryIdx < Entries.count() && TotalSize > mMaxSize; EntryIdx++)
+	{
+		if (QDir(Entries[EntryIdx].Path).removeRecursively())
+			TotalSize -= Entries[EntryIdx].Size;
+	}
+}
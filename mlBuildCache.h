@@ -0,0 +1,84 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+class mlBuildManifest
+{
+public:
+	mlBuildManifest(const QString& FileName, const QString& GamePath, const QString& ToolsPath);
+
+	static QString DefaultFileName(const QString& ToolsPath);
+
+	bool Load();
+	bool Save();
+
+	QByteArray HashFile(const QString& FileName);
+	QByteArray StepKey(const mlBuildStep& Step, const QList<QByteArray>& DependencyKeys);
+	bool IsUpToDate(const mlBuildStep& Step, const QByteArray& Key) const;
+	void SetStepKey(const QString& StepName, const QByteArray& Key);
+	void RemoveStep(const QString& StepName);
+
+	QString NormalizePath(const QString& Path) const;
+	QString DenormalizePath(const QString& Path) const;
+
+	static QStringList ExpandFiles(const QStringList& Paths, const QStringList& ExcludedPaths = QStringList());
+
+protected:
+	struct mlFileEntry
+	{
+		qint64 Size;
+		qint64 Modified;
+		QByteArray Hash;
+	};
+
+	QString mFileName;
+	QString mGamePath;
+	QString mToolsPath;
+	QHash<QString, mlFileEntry> mFiles;
+	QHash<QString, QByteArray> mSteps;
+	bool mDirty;
+};
+
+// Size and modification time of each file below a step's outputs, taken before the step runs
+typedef QHash<QString, QPair<qint64, qint64> > mlOutputSnapshot;
+
+// Content addressed store of step outputs, keyed by the step key so it can be shared between checkouts, users and machines
+class mlArtifactCache
+{
+public:
+	mlArtifactCache(const QString& CacheDir, qint64 MaxSize);
+
+	bool IsEnabled() const
+	{
+		return !mCacheDir.isEmpty();
+	}
+
+	bool Contains(const QByteArray& Key) const;
+	bool Restore(const QByteArray& Key, const mlBuildManifest& Manifest);
+	bool Store(const QByteArray& Key, const mlBuildStep& Step, const mlOutputSnapshot& Before, const mlBuildManifest& Manifest);
+	void Evict();
+
+	static mlOutputSnapshot Snapshot(const mlBuildStep& Step);
+
+protected:
+	QString EntryPath(const QByteArray& Key) const;
+
+	QString mCacheDir;
+	qint64 mMaxSize;
+};
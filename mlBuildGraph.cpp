@@ -0,0 +1,314 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "stdafx.h"
+
+const char* gLanguages[] = { "english", "french", "italian", "spanish", "german", "portuguese", "russian", "polish", "japanese", "traditionalchinese", "simplifiedchinese", "englisharabic" };
+const char* gModZones[] = { "core_mod", "mp_mod", "cp_mod", "zm_mod" };
+
+// Files outside of the map or mod folder that a zone pulls in: the raw files it lists by path, and every file a GDT in
+// the gdts folder of the map or mod refers to, such as model_export bins, images and sounds. GDT values are paths relative to the game
+// folder or to one of the asset folders, only the ones that exist are inputs.
+static QStringList LinkAssetInputs(const QString& GamePath, const QString& Folder)
+{
+	QRegularExpression ZoneEntry("^\\s*\\w+\\s*,\\s*([^\\s,]+[/\\\\][^\\s,]+\\.[A-Za-z]\\w*)");
+	QRegularExpression GDTValue("\"[^\"]*\"\\s+\"([^\"]+\\.[A-Za-z]\\w*)\"");
+	const QStringList AssetRoots = QStringList() << GamePath << GamePath + "/share/raw" << GamePath + "/model_export" << GamePath + "/texture_assets" << GamePath + "/sound_assets";
+
+	QSet<QString> Inputs;
+
+	auto AddAsset = [&](const QString& Path)
+	{
+		QString RelativePath = QDir::fromNativeSeparators(Path);
+		if (QDir::isAbsolutePath(RelativePath))
+		{
+			if (QFileInfo(RelativePath).isFile())
+				Inputs.insert(QDir::cleanPath(RelativePath));
+			return;
+		}
+
+		for (const QString& Root : AssetRoots)
+		{
+			QString FileName = QDir::cleanPath(Root + '/' + RelativePath);
+			if (QFileInfo(FileName).isFile())
+			{
+				Inputs.insert(FileName);
+				return;
+			}
+		}
+	};
+
+	auto ScanFiles = [&](const QStringList& FileNames, const QRegularExpression& Pattern)
+	{
+		for (const QString& FileName : FileNames)
+		{
+			QFile File(FileName);
+			if (!File.open(QIODevice::ReadOnly | QIODevice::Text))
+				continue;
+
+			while (!File.atEnd())
+			{
+				QRegularExpressionMatchIterator It = Pattern.globalMatch(QString::fromUtf8(File.readLine()));
+				while (It.hasNext())
+					AddAsset(It.next().captured(1));
+			}
+		}
+	};
+
+	ScanFiles(mlBuildManifest::ExpandFiles(QStringList() << Folder + "/zone_source/*.zone"), ZoneEntry);
+	ScanFiles(mlBuildManifest::ExpandFiles(QStringList() << Folder + "/gdts/*.gdt"), GDTValue);
+
+	QStringList Result = Inputs.toList();
+	Result.sort(Qt::CaseInsensitive);
+	return Result;
+}
+
+// The linker writes the fastfiles to zone/ and the asset lists of each language below zone_source/, so the zone files,
+// the other folders of the map or mod and the assets they refer to are the inputs of a link
+static QStringList LinkInputs(const QString& GamePath, const QString& Folder)
+{
+	QStringList Inputs;
+	Inputs << Folder + "/zone_source/*.zone";
+
+	for (const QFileInfo& Entry : QDir(Folder).entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot))
+		if (Entry.fileName().compare("zone", Qt::CaseInsensitive) != 0 && Entry.fileName().compare("zone_source", Qt::CaseInsensitive) != 0)
+			Inputs << Entry.filePath();
+
+	Inputs << LinkAssetInputs(GamePath, Folder);
+	return Inputs;
+}
+
+mlBuildGraph mlBuildGraph::Create(const QList<mlBuildItem>& Items, const mlBuildOptions& Options)
+{
+	mlBuildGraph Graph;
+	int UpdateStep = -1;
+
+	auto AddUpdateDBCommand = [&]() -> int
+	{
+		if (UpdateStep == -1)
+			UpdateStep = Graph.AddUpdateDBStep(Options);
+
+		return UpdateStep;
+	};
+
+	QString LastMap, LastMod;
+
+	// A single linker links every language, they all share the fastfiles that aren't localized
+	QStringList LanguageArgs;
+	if (Options.Language != "All")
+		LanguageArgs << "-language" << Options.Language;
+	else
+	{
+		for (const QString& Language : gLanguages)
+			LanguageArgs << "-language" << Language;
+	}
+
+	auto AddLinkStep = [&](const QString& Name, const QStringList& Args, const QList<int>& Dependencies, const QStringList& Inputs, const QStringList& Outputs) -> void
+	{
+		int LinkStep = Graph.AddStep(Name, QString("%1/bin/linker_modtools.exe").arg(Options.ToolsPath), QStringList() << LanguageArgs << Args, Dependencies);
+		Graph.SetFiles(LinkStep, Inputs, Outputs);
+	};
+
+	const QString SourceGDTs = QString("%1/source_data/*.gdt").arg(Options.ToolsPath);
+
+	for (const mlBuildItem& Item : Items)
+	{
+		if (Item.Type == ML_ITEM_MAP)
+		{
+			QString MapName = Item.Name;
+			QString MapFile = QString("%1/map_source/%2/%3.map").arg(Options.GamePath, MapName.left(2), MapName);
+			QString PrefabsFolder = QString("%1/map_source/_prefabs").arg(Options.GamePath);
+			QString BSPFile = QString("%1/share/raw/maps/%2/%3.d3dbsp").arg(Options.GamePath, MapName.left(2), MapName);
+			QString MapGDTs = QString("%1/usermaps/%2/gdts/*.gdt").arg(Options.GamePath, MapName);
+			int LastStep = -1;
+
+			if (Options.Compile)
+			{
+				AddUpdateDBCommand();
+
+				QStringList Args;
+				Args << "-platform" << "pc";
+
+				if (Options.CompileEntsOnly)
+					Args << "-onlyents";
+				else
+					Args << "-navmesh" << "-navvolume";
+
+				Args << "-loadFrom" << QString("%1\\map_source\\%2\\%3.map").arg(Options.GamePath, MapName.left(2), MapName);
+				Args << QString("%1\\share\\raw\\maps\\%2\\%3.d3dbsp").arg(Options.GamePath, MapName.left(2), MapName);
+
+				LastStep = Graph.AddStep(QString("compile %1").arg(MapName), QString("%1\\bin\\cod2map64.exe").arg(Options.ToolsPath), Args, QList<int>() << UpdateStep);
+				Graph.SetFiles(LastStep, QStringList() << MapFile << PrefabsFolder << MapGDTs << SourceGDTs, QStringList() << BSPFile);
+			}
+
+			if (Options.Light)
+			{
+				AddUpdateDBCommand();
+
+				QStringList Args;
+				Args << "-ledSilent";
+
+				switch (Options.LightQuality)
+				{
+				case 0:
+					Args << "+low";
+					break;
+
+				default:
+				case 1:
+					Args << "+medium";
+					break;
+
+				case 2:
+					Args << "+high";
+					break;
+				}
+
+				Args << "+localprobes" << "+forceclean" << "+recompute" << MapFile;
+				LastStep = Graph.AddStep(QString("light %1").arg(MapName), QString("%1/bin/radiant_modtools.exe").arg(Options.ToolsPath), Args, QList<int>() << UpdateStep << LastStep);
+				Graph.SetFiles(LastStep, QStringList() << MapFile << PrefabsFolder << MapGDTs << SourceGDTs, QStringList() << BSPFile);
+			}
+
+			if (Options.Link)
+			{
+				AddUpdateDBCommand();
+
+				QString MapFolder = QString("%1/usermaps/%2").arg(Options.GamePath, MapName);
+				AddLinkStep(QString("link %1").arg(MapName), QStringList() << "-modsource" << MapName, QList<int>() << UpdateStep << LastStep, LinkInputs(Options.GamePath, MapFolder) << BSPFile << SourceGDTs, QStringList() << MapFolder + "/zone");
+			}
+
+			LastMap = MapName;
+		}
+		else
+		{
+			QString ModName = Item.Name;
+
+			if (Options.Link)
+			{
+				AddUpdateDBCommand();
+
+				QString ZoneName = Item.Zone;
+				QString ModFolder = QString("%1/mods/%2").arg(Options.GamePath, ModName);
+				AddLinkStep(QString("link %1/%2").arg(ModName, ZoneName), QStringList() << "-fs_game" << ModName << "-modsource" << ZoneName, QList<int>() << UpdateStep, LinkInputs(Options.GamePath, ModFolder) << SourceGDTs, QStringList() << ModFolder + "/zone");
+			}
+
+			LastMod = ModName;
+		}
+	}
+
+	if (Options.Run && (!LastMod.isEmpty() || !LastMap.isEmpty()))
+	{
+		QStringList Args;
+
+		if(!Options.RunDvars.isEmpty())
+			Args << Options.RunDvars;
+
+		Args << "+set" << "fs_game" << (LastMod.isEmpty() ? LastMap : LastMod);
+
+		if (!LastMap.isEmpty())
+			Args << "+devmap" << LastMap;
+
+		if (!Options.RunOptions.isEmpty())
+			Args << Options.RunOptions.split(' ');
+
+		// The game is only started once everything else has been built
+		QList<int> Dependencies;
+		for (int StepIdx = 0; StepIdx < Graph.Count(); StepIdx++)
+			Dependencies.append(StepIdx);
+
+		Graph.AddStep("run", QString("%1/BlackOps3.exe").arg(Options.GamePath), Args, Dependencies);
+	}
+
+	return Graph;
+}
+
+int mlBuildGraph::AddStep(const QString& Name, const QString& Executable, const QStringList& Arguments, const QList<int>& Dependencies)
+{
+	mlBuildStep Step;
+	Step.Name = Name;
+	Step.Executable = Executable;
+	Step.Arguments = Arguments;
+
+	// Steps can only depend on steps that were added before them, which keeps the graph acyclic
+	for (int DependencyIdx : Dependencies)
+		if (DependencyIdx >= 0 && DependencyIdx < mSteps.count() && !Step.Dependencies.contains(DependencyIdx))
+			Step.Dependencies.append(DependencyIdx);
+
+	mSteps.append(Step);
+	return mSteps.count() - 1;
+}
+
+// gdtdb only needs to run when a GDT was added, removed or modified since the last successful update, or when its
+// database is gone. Forcing the update keeps the key the same. The other steps only wait for it, the GDTs they read
+// are their own inputs, so their keys don't change with every GDT of every map and mod in this checkout.
+int mlBuildGraph::AddUpdateDBStep(const mlBuildOptions& Options)
+{
+	int UpdateStep = AddStep("gdtdb", QString("%1/gdtdb/gdtdb.exe").arg(Options.ToolsPath), QStringList() << "/update");
+
+	// Maps and mods keep their GDTs in gdts/, only those folders are searched instead of every file of every map and mod
+	QStringList Inputs;
+	Inputs << QString("%1/source_data/*.gdt").arg(Options.ToolsPath);
+
+	for (const QString& Root : QStringList() << Options.GamePath + "/usermaps" << Options.GamePath + "/mods")
+		for (const QString& Item : QDir(Root).entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+			Inputs << QString("%1/%2/gdts/*.gdt").arg(Root, Item);
+
+	SetFiles(UpdateStep, Inputs, QStringList() << QString("%1/gdtdb/gdt.db").arg(Options.ToolsPath));
+	mSteps[UpdateStep].Force = Options.ForceUpdateDB;
+	mSteps[UpdateStep].OrderOnly = true;
+
+	return UpdateStep;
+}
+
+// Steps that list their inputs are skipped by mlBuildThread when none of them changed since the outputs were built
+void mlBuildGraph::SetFiles(int StepIdx, const QStringList& Inputs, const QStringList& Outputs)
+{
+	mSteps[StepIdx].Inputs = Inputs;
+	mSteps[StepIdx].Outputs = Outputs;
+}
+
+// Paths overlap when one contains the other, outputs with a wildcard in the same folder only overlap when the pattern is the same
+static bool PathsOverlap(const QString& Left, const QString& Right)
+{
+	QString LeftPath = QDir::cleanPath(QDir::fromNativeSeparators(Left));
+	QString RightPath = QDir::cleanPath(QDir::fromNativeSeparators(Right));
+	QFileInfo LeftInfo(LeftPath), RightInfo(RightPath);
+
+	bool LeftPattern = LeftInfo.fileName().contains('*');
+	bool RightPattern = RightInfo.fileName().contains('*');
+
+	if (LeftPattern && RightPattern && LeftInfo.path().compare(RightInfo.path(), Qt::CaseInsensitive) == 0)
+		return LeftPath.compare(RightPath, Qt::CaseInsensitive) == 0;
+
+	if (LeftPattern)
+		LeftPath = LeftInfo.path();
+	if (RightPattern)
+		RightPath = RightInfo.path();
+
+	return LeftPath.compare(RightPath, Qt::CaseInsensitive) == 0 || LeftPath.startsWith(RightPath + '/', Qt::CaseInsensitive) || RightPath.startsWith(LeftPath + '/', Qt::CaseInsensitive);
+}
+
+bool mlBuildGraph::OutputsOverlap(int StepIdx, int OtherIdx) const
+{
+	for (const QString& Output : mSteps[StepIdx].Outputs)
+		for (const QString& OtherOutput : mSteps[OtherIdx].Outputs)
+			if (PathsOverlap(Output, OtherOutput))
+				return true;
+
+	return false;
+}
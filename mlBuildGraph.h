@@ -0,0 +1,133 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+enum mlItemType
+{
+	ML_ITEM_UNKNOWN,
+	ML_ITEM_MAP,
+	ML_ITEM_MOD
+};
+
+enum mlBuildStepStatus
+{
+	ML_STEP_PENDING,
+	ML_STEP_RUNNING,
+	ML_STEP_SUCCEEDED,
+	ML_STEP_FAILED,
+	ML_STEP_SKIPPED,
+	ML_STEP_UP_TO_DATE
+};
+
+struct mlBuildStep
+{
+	mlBuildStep()
+		: Force(false), OrderOnly(false)
+	{
+	}
+
+	QString Name;
+	QString Executable;
+	QStringList Arguments;
+	QList<int> Dependencies;
+	QStringList Inputs;
+	QStringList Outputs;
+	bool Force;
+	bool OrderOnly;
+};
+
+// A map, or a single zone of a mod
+struct mlBuildItem
+{
+	mlBuildItem()
+		: Type(ML_ITEM_UNKNOWN)
+	{
+	}
+
+	mlBuildItem(mlItemType ItemType, const QString& ItemName, const QString& ItemZone = QString())
+		: Type(ItemType), Name(ItemName), Zone(ItemZone)
+	{
+	}
+
+	mlItemType Type;
+	QString Name;
+	QString Zone;
+};
+
+struct mlBuildOptions
+{
+	mlBuildOptions()
+		: Compile(false), CompileEntsOnly(false), Light(false), LightQuality(1), Link(false), Run(false), Language("english"), ForceUpdateDB(false), IgnoreErrors(false), ForceRebuild(false), AbortOnFatalError(false), MaxJobs(1), MemoryBudget(0), ArtifactCacheSize(0)
+	{
+	}
+
+	bool Compile;
+	bool CompileEntsOnly;
+	bool Light;
+	int LightQuality;
+	bool Link;
+	bool Run;
+	QString RunOptions;
+	QStringList RunDvars;
+	QString Language;
+	bool ForceUpdateDB;
+
+	bool IgnoreErrors;
+	bool ForceRebuild;
+	bool AbortOnFatalError;
+	int MaxJobs;
+	qint64 MemoryBudget;
+	QString GamePath;
+	QString ToolsPath;
+	QString ArtifactCacheDir;
+	qint64 ArtifactCacheSize;
+};
+
+extern const char* gLanguages[12];
+extern const char* gModZones[4];
+
+class mlBuildGraph
+{
+public:
+	static mlBuildGraph Create(const QList<mlBuildItem>& Items, const mlBuildOptions& Options);
+
+	int AddStep(const QString& Name, const QString& Executable, const QStringList& Arguments, const QList<int>& Dependencies = QList<int>());
+	int AddUpdateDBStep(const mlBuildOptions& Options);
+	void SetFiles(int StepIdx, const QStringList& Inputs, const QStringList& Outputs);
+
+	bool IsEmpty() const
+	{
+		return mSteps.isEmpty();
+	}
+
+	int Count() const
+	{
+		return mSteps.count();
+	}
+
+	const mlBuildStep& Step(int StepIdx) const
+	{
+		return mSteps[StepIdx];
+	}
+
+	bool OutputsOverlap(int StepIdx, int OtherIdx) const;
+
+protected:
+	QList<mlBuildStep> mSteps;
+};
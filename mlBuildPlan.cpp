@@ -0,0 +1,120 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "stdafx.h"
+
+// Follows the same rules as mlBuildThread: a step is up to date when its key matches the last successful run, and its
+// key includes the keys its dependencies are expected to have. Keys of restored dependencies are known up front, but
+// a step depending on a step that runs is expected to run as well since the files it reads will change.
+mlBuildPlan::mlBuildPlan(const mlBuildGraph& Graph, const mlBuildOptions& Options)
+	: mActions(Graph.Count(), ML_PLAN_RUN), mFallbacks(Graph.Count(), false), mTotal(0), mHasHistory(true)
+{
+	mlBuildManifest Manifest(mlBuildManifest::DefaultFileName(Options.ToolsPath), Options.GamePath, Options.ToolsPath);
+	Manifest.Load();
+
+	mlArtifactCache Artifacts(Options.ArtifactCacheDir, Options.ArtifactCacheSize);
+
+	mlBuildProfiles Profiles(mlBuildProfiles::DefaultFileName(Options.ToolsPath));
+	Profiles.Load();
+
+	mDurations = EstimateDurations(Graph, Profiles);
+
+	QVector<QByteArray> Keys(Graph.Count());
+	QVector<qint64> Remaining(Graph.Count(), 0);
+
+	for (int StepIdx = 0; StepIdx < Graph.Count(); StepIdx++)
+	{
+		const mlBuildStep& Step = Graph.Step(StepIdx);
+		bool DependencyRuns = false;
+		QList<QByteArray> DependencyKeys;
+
+		for (int DependencyIdx : Step.Dependencies)
+		{
+			if (Graph.Step(DependencyIdx).OrderOnly)
+				continue;
+
+			DependencyRuns |= (mActions[DependencyIdx] == ML_PLAN_RUN);
+			DependencyKeys.append(Keys[DependencyIdx]);
+		}
+
+		if (!Step.Inputs.isEmpty() && !Options.ForceRebuild)
+		{
+			Keys[StepIdx] = Manifest.StepKey(Step, DependencyKeys);
+
+			if (Step.Force || DependencyRuns)
+				mActions[StepIdx] = ML_PLAN_RUN;
+			else if (Manifest.IsUpToDate(Step, Keys[StepIdx]))
+				mActions[StepIdx] = ML_PLAN_UP_TO_DATE;
+			else if (Artifacts.Contains(Keys[StepIdx]))
+				mActions[StepIdx] = ML_PLAN_RESTORE;
+		}
+
+		if (mActions[StepIdx] == ML_PLAN_RUN)
+		{
+			Remaining[StepIdx] = mDurations[StepIdx];
+
+			if (Step.Name != "run" && !Profiles.HasProfile(Step))
+			{
+				mFallbacks[StepIdx] = (mDurations[StepIdx] > 0);
+				mHasHistory = false;
+			}
+		}
+	}
+
+	mTotal = Simulate(Graph, Remaining, Options.MaxJobs);
+}
+
+// Milliseconds each step took last time, the game itself isn't part of the build so it never counts
+QVector<qint64> mlBuildPlan::EstimateDurations(const mlBuildGraph& Graph, const mlBuildProfiles& Profiles)
+{
+	QVector<qint64> Durations(Graph.Count(), 0);
+
+	for (int StepIdx = 0; StepIdx < Graph.Count(); StepIdx++)
+		if (Graph.Step(StepIdx).Name != "run")
+			Durations[StepIdx] = Profiles.EstimateDuration(Graph.Step(StepIdx));
+
+	return Durations;
+}
+
+// Plays the build through in step order on MaxJobs lanes, each step starting once its dependencies and a lane are free
+qint64 mlBuildPlan::Simulate(const mlBuildGraph& Graph, const QVector<qint64>& Remaining, int MaxJobs)
+{
+	QVector<qint64> Finish(Graph.Count(), 0);
+	QVector<qint64> Lanes(qMax(MaxJobs, 1), 0);
+	qint64 Total = 0;
+
+	for (int StepIdx = 0; StepIdx < Graph.Count(); StepIdx++)
+	{
+		qint64 Ready = 0;
+		for (int DependencyIdx : Graph.Step(StepIdx).Dependencies)
+			Ready = qMax(Ready, Finish[DependencyIdx]);
+
+		if (Remaining[StepIdx] <= 0)
+		{
+			Finish[StepIdx] = Ready;
+			continue;
+		}
+
+		QVector<qint64>::iterator Lane = std::min_element(Lanes.begin(), Lanes.end());
+		Finish[StepIdx] = qMax(Ready, *Lane) + Remaining[StepIdx];
+		*Lane = Finish[StepIdx];
+		Total = qMax(Total, Finish[StepIdx]);
+	}
+
+	return Total;
+}
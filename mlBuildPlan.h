@@ -0,0 +1,69 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+enum mlPlanAction
+{
+	ML_PLAN_RUN,
+	ML_PLAN_RESTORE,
+	ML_PLAN_UP_TO_DATE
+};
+
+// What a build would do without running anything, and how long it should take based on previous builds
+class mlBuildPlan
+{
+public:
+	mlBuildPlan(const mlBuildGraph& Graph, const mlBuildOptions& Options);
+
+	static QVector<qint64> EstimateDurations(const mlBuildGraph& Graph, const mlBuildProfiles& Profiles);
+	static qint64 Simulate(const mlBuildGraph& Graph, const QVector<qint64>& Remaining, int MaxJobs);
+
+	mlPlanAction Action(int StepIdx) const
+	{
+		return mActions[StepIdx];
+	}
+
+	qint64 EstimatedDuration(int StepIdx) const
+	{
+		return mDurations[StepIdx];
+	}
+
+	// The step never ran, its estimate is the average of the same tool for other maps
+	bool IsFallback(int StepIdx) const
+	{
+		return mFallbacks[StepIdx];
+	}
+
+	qint64 EstimatedTotal() const
+	{
+		return mTotal;
+	}
+
+	bool HasHistory() const
+	{
+		return mHasHistory;
+	}
+
+protected:
+	QVector<mlPlanAction> mActions;
+	QVector<qint64> mDurations;
+	QVector<bool> mFallbacks;
+	qint64 mTotal;
+	bool mHasHistory;
+};
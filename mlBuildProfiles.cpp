@@ -0,0 +1,176 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "stdafx.h"
+
+mlBuildProfiles::mlBuildProfiles(const QString& FileName)
+	: mFileName(FileName), mDirty(false)
+{
+}
+
+QString mlBuildProfiles::DefaultFileName(const QString& ToolsPath)
+{
+	return QString("%1/share/modlauncher/build_profiles.json").arg(ToolsPath);
+}
+
+QString mlBuildProfiles::ToolName(const mlBuildStep& Step)
+{
+	return QFileInfo(QString(Step.Executable).replace('\\', '/')).completeBaseName();
+}
+
+// The same map built with different options, such as another light quality, gets a profile of its own
+QString mlBuildProfiles::ProfileKey(const mlBuildStep& Step)
+{
+	QByteArray Arguments = Step.Arguments.join(' ').toUtf8();
+	return Step.Name + '|' + QCryptographicHash::hash(Arguments, QCryptographicHash::Sha1).toHex().left(12);
+}
+
+bool mlBuildProfiles::Load()
+{
+	QFile File(mFileName);
+	if (!File.open(QIODevice::ReadOnly))
+		return false;
+
+	QJsonObject Root = QJsonDocument::fromJson(File.readAll()).object();
+
+	for (QJsonObject::const_iterator It = Root.constBegin(); It != Root.constEnd(); ++It)
+	{
+		QJsonObject ProfileObject = It.value().toObject();
+
+		mlBuildProfile Profile;
+		Profile.Name = ProfileObject["Name"].toString();
+		Profile.Tool = ProfileObject["Tool"].toString();
+		Profile.Arguments = ProfileObject["Arguments"].toString();
+		Profile.PeakMemory = (qint64)ProfileObject["PeakMemory"].toDouble();
+		Profile.UserTime = (qint64)ProfileObject["UserTime"].toDouble();
+		Profile.SystemTime = (qint64)ProfileObject["SystemTime"].toDouble();
+		Profile.Duration = (qint64)ProfileObject["Duration"].toDouble();
+		Profile.Runs = ProfileObject["Runs"].toInt();
+		Profile.LastRun = QDateTime::fromString(ProfileObject["LastRun"].toString(), Qt::ISODate);
+		mProfiles.insert(It.key(), Profile);
+	}
+
+	mDirty = false;
+	return true;
+}
+
+bool mlBuildProfiles::Save()
+{
+	if (!mDirty)
+		return true;
+
+	QJsonObject Root;
+	for (QHash<QString, mlBuildProfile>::const_iterator It = mProfiles.constBegin(); It != mProfiles.constEnd(); ++It)
+	{
+		QJsonObject ProfileObject;
+		ProfileObject["Name"] = It->Name;
+		ProfileObject["Tool"] = It->Tool;
+		ProfileObject["Arguments"] = It->Arguments;
+		ProfileObject["PeakMemory"] = (double)It->PeakMemory;
+		ProfileObject["UserTime"] = (double)It->UserTime;
+		ProfileObject["SystemTime"] = (double)It->SystemTime;
+		ProfileObject["Duration"] = (double)It->Duration;
+		ProfileObject["Runs"] = It->Runs;
+		ProfileObject["LastRun"] = It->LastRun.toString(Qt::ISODate);
+		Root[It.key()] = ProfileObject;
+	}
+
+	QDir().mkpath(QFileInfo(mFileName).absolutePath());
+
+	QSaveFile File(mFileName);
+	if (!File.open(QIODevice::WriteOnly))
+		return false;
+
+	File.write(QJsonDocument(Root).toJson());
+	if (!File.commit())
+		return false;
+
+	mDirty = false;
+	return true;
+}
+
+void mlBuildProfiles::Clear()
+{
+	mProfiles.clear();
+	mDirty = true;
+}
+
+void mlBuildProfiles::Update(const mlBuildStep& Step, const mlTraceEvent& Event)
+{
+	mlBuildProfile& Profile = mProfiles[ProfileKey(Step)];
+	Profile.Name = Step.Name;
+	Profile.Tool = ToolName(Step);
+	Profile.Arguments = Step.Arguments.join(' ');
+	Profile.PeakMemory = Event.Stats.PeakMemory;
+	Profile.UserTime = Event.Stats.UserTime;
+	Profile.SystemTime = Event.Stats.SystemTime;
+	Profile.Duration = (Event.End - Event.Start) / 1000;
+	Profile.Runs++;
+	Profile.LastRun = QDateTime::currentDateTime();
+	mDirty = true;
+}
+
+// Steps that never ran are assumed to need as much as the same tool needed on average for other maps
+qint64 mlBuildProfiles::Estimate(const mlBuildStep& Step, qint64 mlBuildProfile::* Field) const
+{
+	QHash<QString, mlBuildProfile>::const_iterator It = mProfiles.constFind(ProfileKey(Step));
+	if (It != mProfiles.constEnd())
+		return (*It).*Field;
+
+	QString Tool = ToolName(Step);
+	qint64 Total = 0;
+	int Count = 0;
+
+	for (const mlBuildProfile& Profile : mProfiles)
+	{
+		if (Profile.Tool == Tool)
+		{
+			Total += Profile.*Field;
+			Count++;
+		}
+	}
+
+	return Count ? Total / Count : 0;
+}
+
+// Three quarters of the installed memory in GB, leaving room for the editor and the OS. Without a budget every job could
+// start a lighting or linking step at once.
+int mlBuildProfiles::DefaultMemoryBudget()
+{
+	qint64 Memory = mlProcessStatsProbe::PhysicalMemory();
+	if (Memory <= 0)
+		return 0;
+
+	return qMax((int)(Memory * 3 / 4 / (1024 * 1024 * 1024)), 1);
+}
+
+qint64 mlBuildProfiles::EstimateMemory(const mlBuildStep& Step) const
+{
+	return Estimate(Step, &mlBuildProfile::PeakMemory);
+}
+
+qint64 mlBuildProfiles::EstimateDuration(const mlBuildStep& Step) const
+{
+	return Estimate(Step, &mlBuildProfile::Duration);
+}
+
+// Whether the estimates come from this step's own last run rather than the average of the same tool for other maps
+bool mlBuildProfiles::HasProfile(const mlBuildStep& Step) const
+{
+	return mProfiles.contains(ProfileKey(Step));
+}
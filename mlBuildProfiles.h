@@ -0,0 +1,70 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+struct mlBuildProfile
+{
+	mlBuildProfile()
+		: PeakMemory(0), UserTime(0), SystemTime(0), Duration(0), Runs(0)
+	{
+	}
+
+	QString Name;
+	QString Tool;
+	QString Arguments;
+	qint64 PeakMemory;
+	qint64 UserTime;
+	qint64 SystemTime;
+	qint64 Duration;
+	int Runs;
+	QDateTime LastRun;
+};
+
+// Resources each step used the last time it succeeded, used to estimate what a step needs before it runs
+class mlBuildProfiles
+{
+public:
+	mlBuildProfiles(const QString& FileName);
+
+	static QString DefaultFileName(const QString& ToolsPath);
+	static QString ToolName(const mlBuildStep& Step);
+	static int DefaultMemoryBudget();
+
+	bool Load();
+	bool Save();
+	void Clear();
+
+	void Update(const mlBuildStep& Step, const mlTraceEvent& Event);
+	qint64 EstimateMemory(const mlBuildStep& Step) const;
+	qint64 EstimateDuration(const mlBuildStep& Step) const;
+	bool HasProfile(const mlBuildStep& Step) const;
+
+	QList<mlBuildProfile> Profiles() const
+	{
+		return mProfiles.values();
+	}
+
+protected:
+	static QString ProfileKey(const mlBuildStep& Step);
+	qint64 Estimate(const mlBuildStep& Step, qint64 mlBuildProfile::* Field) const;
+
+	QString mFileName;
+	QHash<QString, mlBuildProfile> mProfiles;
+	bool mDirty;
+};
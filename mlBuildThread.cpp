@@ -0,0 +1,952 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+
+#include "stdafx.h"
+
+#include <functional>
+
+mlBuildThread::mlBuildThread(const mlBuildGraph& Graph, const mlBuildOptions& Options)
+	: mGraph(Graph), mOptions(Options), mSuccess(false), mCancel(false)
+{
+	mOptions.MaxJobs = qMax(mOptions.MaxJobs, 1);
+}
+
+static QByteArray TagOutputLines(const QByteArray& Output, const QByteArray& Tag)
+{
+	QByteArray Result;
+	QList<QByteArray> Lines = Output.split('\n');
+
+	for (int LineIdx = 0; LineIdx < Lines.count(); LineIdx++)
+	{
+		if (LineIdx == Lines.count() - 1 && Lines[LineIdx].isEmpty())
+			break;
+
+		Result.append(Tag);
+		Result.append(Lines[LineIdx]);
+		Result.append('\n');
+	}
+
+	return Result;
+}
+
+void mlBuildThread::run()
+{
+	QEventLoop EventLoop;
+	QVector<mlBuildStepStatus> Status(mGraph.Count(), ML_STEP_PENDING);
+	QVector<QProcess*> Processes(mGraph.Count(), NULL);
+	QVector<QByteArray> PendingOutput(mGraph.Count());
+	QVector<QByteArray> Keys(mGraph.Count());
+	QVector<mlProcessStatsProbe*> Probes(mGraph.Count(), NULL);
+	QVector<mlTraceEvent> Events(mGraph.Count());
+	QVector<int> EventIndices(mGraph.Count(), -1);
+	QVector<bool> LaneBusy(mOptions.MaxJobs, false);
+	int RunningCount = 0;
+	bool Success = true;
+
+	mTrace.Start();
+
+	mlBuildManifest Manifest(mlBuildManifest::DefaultFileName(mOptions.ToolsPath), mOptions.GamePath, mOptions.ToolsPath);
+	Manifest.Load();
+
+	mlArtifactCache Artifacts(mOptions.ArtifactCacheDir, mOptions.ArtifactCacheSize);
+
+	mlBuildProfiles Profiles(mlBuildProfiles::DefaultFileName(mOptions.ToolsPath));
+	Profiles.Load();
+
+	QVector<qint64> StepMemory(mGraph.Count(), 0);
+	QVector<bool> WaitingForMemory(mGraph.Count(), false);
+	qint64 RunningMemory = 0;
+
+	QVector<qint64> Durations = mlBuildPlan::EstimateDurations(mGraph, Profiles);
+	QVector<bool> Profiled(mGraph.Count(), false);
+	for (int StepIdx = 0; StepIdx < mGraph.Count(); StepIdx++)
+		Profiled[StepIdx] = Profiles.HasProfile(mGraph.Step(StepIdx));
+	QVector<mlOutputSnapshot> Snapshots(mGraph.Count());
+	QVector<bool> Copying(mGraph.Count(), false);
+	int CopyingCount = 0;
+	bool StoredArtifacts = false;
+
+	// Outputs can be several GB, they are copied to and from the artifact cache on the pool so that output and finished
+	// steps are still handled meanwhile. ArtifactCopied brings the result back to this thread.
+	QObject CopyContext;
+	QThreadPool CopyPool;
+
+	auto CopyArtifacts = [&](int StepIdx, const std::function<bool ()>& Copy) -> void
+	{
+		Copying[StepIdx] = true;
+		CopyingCount++;
+
+		CopyPool.start(new mlFunctionTask([this, StepIdx, Copy]()
+		{
+			emit ArtifactCopied(StepIdx, Copy());
+		}));
+	};
+
+	mlDiagnosticParser DiagnosticParser;
+	QVector<int> StepProgress(mGraph.Count(), -1);
+
+	std::function<void ()> Schedule;
+
+	auto ParseOutput = [&](int StepIdx, const QByteArray& Output) -> void
+	{
+		int ErrorCount = DiagnosticParser.ErrorCount();
+		int WarningCount = DiagnosticParser.WarningCount();
+
+		for (const QByteArray& Line : Output.split('\n'))
+		{
+			mlDiagnostic Diagnostic = DiagnosticParser.ParseLine(QString::fromLocal8Bit(Line));
+			if (Diagnostic.Type == ML_DIAGNOSTIC_PROGRESS)
+				StepProgress[StepIdx] = Diagnostic.Progress;
+
+			// Everything still running or waiting would be wasted time, the build can't succeed anymore
+			if (Diagnostic.Fatal && mOptions.AbortOnFatalError && !mCancel)
+			{
+				emit OutputReady(QString("Aborting the build because of a fatal error in '%1'\n").arg(mGraph.Step(StepIdx).Name));
+				Cancel();
+			}
+		}
+
+		if (ErrorCount != DiagnosticParser.ErrorCount() || WarningCount != DiagnosticParser.WarningCount())
+			emit DiagnosticsUpdated(DiagnosticParser.ErrorCount(), DiagnosticParser.WarningCount());
+	};
+
+	// Only complete lines are forwarded so that steps running in parallel don't break each other's lines up
+	auto ForwardOutput = [&](int StepIdx, bool Flush) -> void
+	{
+		QByteArray& Pending = PendingOutput[StepIdx];
+		Pending.append(Processes[StepIdx]->readAll());
+
+		if (Probes[StepIdx])
+			Probes[StepIdx]->Sample();
+
+		int OutputSize = Flush ? Pending.size() : Pending.lastIndexOf('\n') + 1;
+		if (OutputSize <= 0)
+			return;
+
+		QByteArray Output = Pending.left(OutputSize);
+		Pending.remove(0, OutputSize);
+
+		ParseOutput(StepIdx, Output);
+
+		if (RunningCount > 1)
+			Output = TagOutputLines(Output, '[' + mGraph.Step(StepIdx).Name.toLatin1() + "] ");
+
+		emit OutputReady(Output);
+	};
+
+	auto StartStep = [&](int StepIdx) -> bool
+	{
+		const mlBuildStep& Step = mGraph.Step(StepIdx);
+
+		emit OutputReady(Step.Executable + ' ' + Step.Arguments.join(' ') + "\n");
+
+		QProcess* Process = new QProcess();
+		Process->setWorkingDirectory(QFileInfo(Step.Executable).absolutePath());
+		Process->setProcessChannelMode(QProcess::MergedChannels);
+		Processes[StepIdx] = Process;
+
+		// Only steps that can be stored need to know which of their outputs were there before
+		if (Artifacts.IsEnabled() && !Keys[StepIdx].isEmpty())
+			Snapshots[StepIdx] = mlArtifactCache::Snapshot(Step);
+
+		mlTraceEvent& Event = Events[StepIdx];
+		Event.Name = Step.Name;
+		Event.Category = "build";
+		Event.Start = mTrace.Elapsed();
+		Event.Lane = LaneBusy.indexOf(false);
+		LaneBusy[Event.Lane] = true;
+
+		for (int DependencyIdx : Step.Dependencies)
+			if (EventIndices[DependencyIdx] != -1)
+				Event.Dependencies.append(EventIndices[DependencyIdx]);
+
+		connect(Process, &QProcess::readyRead, [&, StepIdx]()
+		{
+			ForwardOutput(StepIdx, false);
+		});
+
+		connect(Process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), [&, StepIdx](int ExitCode, QProcess::ExitStatus ExitStatus)
+		{
+			ForwardOutput(StepIdx, true);
+
+			mlTraceEvent& Event = Events[StepIdx];
+			Event.End = mTrace.Elapsed();
+			Event.ExitCode = (ExitStatus == QProcess::NormalExit) ? ExitCode : -1;
+			Event.Stats = Probes[StepIdx]->Collect();
+			EventIndices[StepIdx] = mTrace.AddEvent(Event);
+			LaneBusy[Event.Lane] = false;
+
+			RunningMemory -= StepMemory[StepIdx];
+			if (ExitStatus == QProcess::NormalExit && ExitCode == 0)
+				Profiles.Update(mGraph.Step(StepIdx), Event);
+
+			delete Probes[StepIdx];
+			Probes[StepIdx] = NULL;
+
+			Processes[StepIdx]->deleteLater();
+			Processes[StepIdx] = NULL;
+			RunningCount--;
+
+			if (ExitStatus == QProcess::NormalExit && ExitCode == 0)
+			{
+				Status[StepIdx] = ML_STEP_SUCCEEDED;
+				if (!Keys[StepIdx].isEmpty())
+				{
+					const mlBuildStep& FinishedStep = mGraph.Step(StepIdx);
+					Manifest.SetStepKey(FinishedStep.Name, Keys[StepIdx]);
+
+					// Outputs built on top of a failed step are never shared. No other step wrote to the same files while
+					// this one ran, Schedule never runs two steps with overlapping outputs at once.
+					bool DependenciesSucceeded = true;
+					for (int DependencyIdx : FinishedStep.Dependencies)
+						if (Status[DependencyIdx] != ML_STEP_SUCCEEDED && Status[DependencyIdx] != ML_STEP_UP_TO_DATE)
+							DependenciesSucceeded = false;
+
+					if (DependenciesSucceeded && Artifacts.IsEnabled())
+					{
+						const QByteArray Key = Keys[StepIdx];
+						const mlOutputSnapshot Before = Snapshots[StepIdx];
+
+						CopyArtifacts(StepIdx, [&Artifacts, &Manifest, &FinishedStep, Key, Before]()
+						{
+							return Artifacts.Store(Key, FinishedStep, Before, Manifest);
+						});
+					}
+				}
+			}
+			else
+			{
+				Status[StepIdx] = ML_STEP_FAILED;
+				Success = false;
+			}
+
+			Schedule();
+		});
+
+		Process->start(Step.Executable, Step.Arguments);
+		if (!Process->waitForStarted(-1))
+		{
+			emit OutputReady(QString("ERROR: Could not start '%1'\n").arg(Step.Executable));
+			Processes[StepIdx] = NULL;
+			LaneBusy[Event.Lane] = false;
+			delete Process;
+			return false;
+		}
+
+		Probes[StepIdx] = new mlProcessStatsProbe();
+		Probes[StepIdx]->Attach(Process->processId());
+
+		Status[StepIdx] = ML_STEP_RUNNING;
+		RunningCount++;
+		return true;
+	};
+
+	// Progress is weighted by how long each step took last time, steps without any history count as one second.
+	// A running step that reports its own percentage is measured by that instead of by its run time.
+	// The remaining time comes from the same simulation as the build plan, so it is only known when every step left has
+	// run before itself. The average of the same tool for other maps is fine for weighting progress, not for a time.
+	auto ReportProgress = [&]() -> void
+	{
+		qint64 Elapsed = mTrace.Elapsed() / 1000;
+		qint64 TotalWork = 0, RemainingWork = 0;
+		QVector<qint64> Remaining(mGraph.Count(), 0);
+		bool Known = true;
+
+		for (int StepIdx = 0; StepIdx < mGraph.Count(); StepIdx++)
+		{
+			if (Status[StepIdx] == ML_STEP_UP_TO_DATE || Status[StepIdx] == ML_STEP_SKIPPED || mGraph.Step(StepIdx).Name == "run")
+				continue;
+
+			qint64 Weight = qMax(Durations[StepIdx], (qint64)1000);
+			TotalWork += Weight;
+
+			if (Status[StepIdx] == ML_STEP_PENDING || Status[StepIdx] == ML_STEP_RUNNING)
+			{
+				qint64 RunTime = (Status[StepIdx] == ML_STEP_RUNNING) ? Elapsed - Events[StepIdx].Start / 1000 : 0;
+				if (Status[StepIdx] == ML_STEP_RUNNING && StepProgress[StepIdx] >= 0)
+				{
+					Remaining[StepIdx] = Durations[StepIdx] * (100 - StepProgress[StepIdx]) / 100;
+					RemainingWork += Weight * (100 - StepProgress[StepIdx]) / 100;
+				}
+				else
+				{
+					Remaining[StepIdx] = qMax(Durations[StepIdx] - RunTime, (qint64)0);
+					RemainingWork += qMax(Weight - RunTime, (qint64)0);
+				}
+				Known &= Profiled[StepIdx];
+			}
+		}
+
+		int Percent = TotalWork ? (int)(100 * (TotalWork - RemainingWork) / TotalWork) : 100;
+		int RemainingSeconds = Known ? (int)((mlBuildPlan::Simulate(mGraph, Remaining, mOptions.MaxJobs) + 999) / 1000) : -1;
+		emit ProgressUpdated(Percent, RemainingSeconds);
+	};
+
+	// Starts every step whose dependencies are done, up to MaxJobs at a time. A failed step only stops the
+	// steps that depend on it unless errors are ignored, the event loop is stopped once nothing is left running
+	Schedule = [&]() -> void
+	{
+		bool Changed = true;
+		bool MemoryBlocked = false;
+
+		while (Changed)
+		{
+			Changed = false;
+
+			for (int StepIdx = 0; StepIdx < mGraph.Count(); StepIdx++)
+			{
+				if (Status[StepIdx] != ML_STEP_PENDING || Copying[StepIdx])
+					continue;
+
+				const mlBuildStep& Step = mGraph.Step(StepIdx);
+				bool Ready = true;
+				bool Blocked = mCancel;
+				bool DependencyFailed = false;
+
+				for (int DependencyIdx : Step.Dependencies)
+				{
+					mlBuildStepStatus DependencyStatus = Status[DependencyIdx];
+
+					if (DependencyStatus == ML_STEP_SKIPPED || (DependencyStatus == ML_STEP_FAILED && !mOptions.IgnoreErrors))
+						Blocked = true;
+					else if (DependencyStatus == ML_STEP_PENDING || DependencyStatus == ML_STEP_RUNNING)
+						Ready = false;
+					else if (DependencyStatus == ML_STEP_FAILED)
+						DependencyFailed = true;
+				}
+
+				if (Blocked)
+				{
+					if (!mCancel)
+						emit OutputReady(QString("Skipping '%1' because a step it depends on did not succeed\n").arg(Step.Name));
+
+					Status[StepIdx] = ML_STEP_SKIPPED;
+					Success = false;
+					Changed = true;
+					continue;
+				}
+
+				if (!Ready)
+					continue;
+
+				// The key covers the tool, its arguments, the step's input files and the keys of the steps it depends on,
+				// apart from steps it only has to wait for
+				if (!Step.Inputs.isEmpty() && Keys[StepIdx].isEmpty())
+				{
+					QList<QByteArray> DependencyKeys;
+					for (int DependencyIdx : Step.Dependencies)
+						if (!mGraph.Step(DependencyIdx).OrderOnly)
+							DependencyKeys.append(Keys[DependencyIdx]);
+
+					Keys[StepIdx] = Manifest.StepKey(Step, DependencyKeys);
+
+					if (!mOptions.ForceRebuild && !Step.Force && !DependencyFailed && Manifest.IsUpToDate(Step, Keys[StepIdx]))
+					{
+						emit OutputReady(QString("Skipping '%1', none of its inputs changed since it last succeeded\n").arg(Step.Name));
+						Status[StepIdx] = ML_STEP_UP_TO_DATE;
+						Changed = true;
+						continue;
+					}
+
+					Manifest.RemoveStep(Step.Name);
+
+					// The step stays pending while its outputs are restored, it runs after all if the restore fails
+					if (!mOptions.ForceRebuild && !Step.Force && !DependencyFailed && Artifacts.Contains(Keys[StepIdx]))
+					{
+						const QByteArray Key = Keys[StepIdx];
+
+						CopyArtifacts(StepIdx, [&Artifacts, &Manifest, Key]()
+						{
+							return Artifacts.Restore(Key, Manifest);
+						});
+						continue;
+					}
+				}
+
+				// Steps start in order, so a step waiting for memory isn't starved by smaller steps after it
+				if (RunningCount >= mOptions.MaxJobs || MemoryBlocked)
+					continue;
+
+				// Two steps never write the same files at the same time, the step waits without holding up the ones after it
+				bool OutputsBusy = false;
+				for (int OtherIdx = 0; OtherIdx < mGraph.Count() && !OutputsBusy; OtherIdx++)
+					OutputsBusy = ((Status[OtherIdx] == ML_STEP_RUNNING || Copying[OtherIdx]) && mGraph.OutputsOverlap(StepIdx, OtherIdx));
+
+				if (OutputsBusy)
+					continue;
+
+				// Unless nothing else is running, a step only starts when its estimated memory fits in the budget next to the running steps
+				qint64 Memory = Profiles.EstimateMemory(Step);
+				if (mOptions.MemoryBudget > 0 && RunningCount > 0 && RunningMemory + Memory > mOptions.MemoryBudget)
+				{
+					if (!WaitingForMemory[StepIdx])
+						emit OutputReady(QString("Waiting for memory to start '%1', it used %2 GB last time\n").arg(Step.Name).arg(Memory / (1024.0 * 1024.0 * 1024.0), 0, 'f', 1));
+
+					WaitingForMemory[StepIdx] = true;
+					MemoryBlocked = true;
+					continue;
+				}
+
+				if (StartStep(StepIdx))
+				{
+					StepMemory[StepIdx] = Memory;
+					RunningMemory += Memory;
+				}
+				else
+				{
+					Status[StepIdx] = ML_STEP_FAILED;
+					Success = false;
+				}
+
+				Changed = true;
+			}
+		}
+
+		ReportProgress();
+
+		if (RunningCount == 0 && CopyingCount == 0)
+			EventLoop.quit();
+	};
+
+	connect(this, &mlBuildThread::ArtifactCopied, &CopyContext, [&](int StepIdx, bool CopySucceeded)
+	{
+		Copying[StepIdx] = false;
+		CopyingCount--;
+
+		// A step that is still pending was being restored, one that succeeded was being stored
+		if (Status[StepIdx] == ML_STEP_PENDING && CopySucceeded)
+		{
+			const mlBuildStep& Step = mGraph.Step(StepIdx);
+			emit OutputReady(QString("Restored the outputs of '%1' from the artifact cache\n").arg(Step.Name));
+			Manifest.SetStepKey(Step.Name, Keys[StepIdx]);
+			Status[StepIdx] = ML_STEP_SUCCEEDED;
+		}
+		else if (Status[StepIdx] == ML_STEP_SUCCEEDED && CopySucceeded)
+			StoredArtifacts = true;
+
+		Schedule();
+	});
+
+	// Steps that print nothing for a while still have their memory sampled
+	QTimer ProgressTimer;
+	connect(&ProgressTimer, &QTimer::timeout, [&]()
+	{
+		for (mlProcessStatsProbe* Probe : Probes)
+			if (Probe)
+				Probe->Sample();
+
+		ReportProgress();
+	});
+	ProgressTimer.start(1000);
+
+	// Cancel() is called from the UI thread or on a fatal error, the processes have to be killed from the thread that owns them
+	QObject CancelContext;
+	connect(this, &mlBuildThread::CancelRequested, &CancelContext, [&]()
+	{
+		for (QProcess* Process : Processes)
+			if (Process)
+				Process->kill();
+	});
+
+	Schedule();
+	if (RunningCount > 0 || CopyingCount > 0)
+		EventLoop.exec();
+
+	Manifest.Save();
+	Profiles.Save();
+
+	if (StoredArtifacts)
+		Artifacts.Evict();
+
+	mTrace.MarkCriticalPath();
+	if (!mTrace.IsEmpty())
+		emit OutputReady(mTrace.Summary());
+
+	if (DiagnosticParser.ErrorCount() || DiagnosticParser.WarningCount())
+		emit OutputReady(QString("%1 error(s), %2 warning(s)\n").arg(DiagnosticParser.ErrorCount()).arg(DiagnosticParser.WarningCount()));
+
+	// The missing assets are spread over the output of every step, listing them together saves searching for each one
+	QStringList MissingAssets = DiagnosticParser.MissingAssets();
+	if (!MissingAssets.isEmpty())
+		emit OutputReady(QString("%1 of %2 referenced asset(s) missing:\n    %3\n").arg(MissingAssets.count()).arg(DiagnosticParser.ReferencedAssets().count()).arg(MissingAssets.join("\n    ")));
+
+	mSuccess = Success && !mCancel;
+}
+
+mlConvertThread::mlConvertThread(QStringList& Files, QString& OutputDir, bool IgnoreErrors, mlOverwriteMode OverwriteMode, int MaxJobs)
+	: mFiles(Files), mOutputDir(OutputDir), mOverwriteMode(OverwriteMode), mMaxJobs(qMax(MaxJobs, 1)), mPreflight(true), mSuccess(false), mCancel(false), mIgnoreErrors(IgnoreErrors), mFailedCount(0)
+{
+	QString ToolsPath = QDir::fromNativeSeparators(getenv("TA_TOOLS_PATH"));
+	mToolExecutable = QString("%1bin/export2bin.exe").arg(ToolsPath);
+	mToolArguments << "/piped";
+}
+
+// Up to mMaxJobs files are converted at once. Everything runs on this thread's event loop, so the counters need no
+// locking, and the output of each file is emitted in one piece when it finishes so files never interleave in the log.
+void mlConvertThread::run()
+{
+	QEventLoop EventLoop;
+	bool Success = true;
+	bool Stopping = false;
+
+	// Dropped folders are searched here rather than in the UI, large export trees would stall the window
+	QList<QPair<qint64, QString>> Files;
+	qint64 TotalSize = 0;
+
+	for (const QString& Path : mFiles)
+	{
+		if (QFileInfo(Path).isDir())
+		{
+			QDirIterator It(Path, QStringList() << "*.xmodel_export" << "*.xanim_export", QDir::Files, QDirIterator::Subdirectories);
+			while (It.hasNext())
+			{
+				It.next();
+				Files.append(qMakePair(It.fileInfo().size(), It.filePath()));
+			}
+		}
+		else
+			Files.append(qMakePair(QFileInfo(Path).size(), Path));
+	}
+
+	// Largest files first, so a big animation does not start last and leave the other jobs idle while it finishes
+	std::stable_sort(Files.begin(), Files.end(), [](const QPair<qint64, QString>& A, const QPair<qint64, QString>& B)
+	{
+		return A.first > B.first;
+	});
+
+	// The target only depends on the base name, exports with the same name in different subfolders would all be written
+	// to the same file in whatever order they finish. None of them is converted.
+	QHash<QString, QStringList> TargetSources;
+
+	mFiles.clear();
+	for (const QPair<qint64, QString>& File : Files)
+	{
+		QFileInfo FileInfo(File.second);
+		QStringList& Sources = TargetSources[(FileInfo.baseName() + '.' + FileInfo.suffix()).toLower()];
+		if (!Sources.contains(FileInfo.absoluteFilePath(), Qt::CaseInsensitive))
+			Sources << FileInfo.absoluteFilePath();
+
+		mFiles << File.second;
+		TotalSize += File.first;
+	}
+
+	emit ConvertStarted(mFiles.count(), (int)((TotalSize + 1023) / 1024));
+
+	unsigned int convCountSuccess	= 0;
+	unsigned int convCountSkipped	= 0;
+	unsigned int convCountFailed	= 0;
+	unsigned int convCountUnchanged	= 0;
+
+	mlDiagnosticParser DiagnosticParser;
+
+	// Every conversion is recorded whatever the mode, so switching to 'Only if Changed' later does not convert everything once more
+	mlConvertManifest Manifest(mOutputDir);
+	Manifest.Load();
+	QByteArray ToolHash = mlConvertManifest::HashFile(mToolExecutable);
+
+	// Exports are streamed through export2bin in chunks and only a capped amount of stderr is kept, so memory use does
+	// not depend on the size of the files. The output is written to a temporary file that replaces the target on commit.
+	const qint64 ChunkSize = 256 * 1024;
+	const int MaxErrorSize = 64 * 1024;
+
+	struct mlConvertJob
+	{
+		mlConvertJob()
+			: Process(NULL), Input(NULL), Output(NULL), Validator(NULL), InputHash(QCryptographicHash::Sha1), BytesIn(0), BytesOut(0), ErrorsTruncated(false), SkippingErrorLine(false), WriteFailed(false)
+		{
+		}
+
+		~mlConvertJob()
+		{
+			delete Input;
+			delete Output;
+			delete Validator;
+		}
+
+		QProcess* Process;
+		QFile* Input;
+		QSaveFile* Output;
+		mlExportParser* Validator;
+		mlExportStats ExportStats;
+		QFileInfo Source;
+		QCryptographicHash InputHash;
+		qint64 BytesIn;
+		qint64 BytesOut;
+		QString Name;
+		QString TargetFile;
+		QByteArray Errors;
+		QByteArray PendingErrors;
+		bool ErrorsTruncated;
+		bool SkippingErrorLine;
+		bool WriteFailed;
+		mlProcessStatsProbe Probe;
+		mlTraceEvent Event;
+	};
+
+	QList<mlConvertJob*> Jobs;
+	QVector<int> LaneEvents(mMaxJobs, -1);
+	QVector<bool> LaneBusy(mMaxJobs, false);
+	int NextFile = 0;
+
+	mTrace.Start();
+
+	std::function<void ()> Schedule;
+
+	auto ReportFile = [&](const QString& File, mlConvertStatus Status, int ExitCode, qint64 BytesIn, qint64 BytesOut, qint64 Duration, const QString& Assets) -> void
+	{
+		emit FileFinished(File, Status, ExitCode, (int)((BytesIn + 1023) / 1024), (int)((BytesOut + 1023) / 1024), (int)(Duration / 1000), Assets);
+	};
+
+	// Keeps at most two chunks queued on stdin, the next chunk is read when the process has consumed the previous one.
+	// The preflight validation parses the same chunks, so each export is only read once and a broken one stops export2bin
+	// before it sees the end of its input. Nothing is written for it, the output is only committed after a clean exit.
+	auto WriteInput = [&](mlConvertJob* Job) -> void
+	{
+		while (Job->Input && Job->Process->bytesToWrite() < ChunkSize)
+		{
+			QByteArray Chunk = Job->Input->read(ChunkSize);
+
+			if (Job->Validator)
+			{
+				Job->Validator->Feed(Chunk.constData(), Chunk.size());
+				Job->ExportStats = Chunk.isEmpty() ? Job->Validator->Finish() : Job->Validator->Stats();
+
+				if (Chunk.isEmpty() || !Job->ExportStats.IsValid())
+				{
+					delete Job->Validator;
+					Job->Validator = NULL;
+				}
+			}
+
+			if (!Job->ExportStats.IsValid())
+			{
+				delete Job->Input;
+				Job->Input = NULL;
+				Job->Process->kill();
+				break;
+			}
+
+			if (Chunk.isEmpty())
+			{
+				delete Job->Input;
+				Job->Input = NULL;
+				Job->Process->closeWriteChannel();
+				break;
+			}
+
+			Job->InputHash.addData(Chunk);
+			Job->BytesIn += Chunk.size();
+			Job->Process->write(Chunk);
+		}
+	};
+
+	auto ReadOutput = [](mlConvertJob* Job) -> void
+	{
+		Job->Probe.Sample();
+
+		QByteArray Chunk = Job->Process->readAllStandardOutput();
+		if (!Chunk.isEmpty() && Job->Output->write(Chunk) != Chunk.size())
+			Job->WriteFailed = true;
+		Job->BytesOut += Chunk.size();
+	};
+
+	// Diagnostics are parsed as stderr streams in, complete lines only unless the process has finished. A line longer
+	// than MaxErrorSize is parsed as far as that and the rest of it is skipped, so a tool that never ends its line can't
+	// grow the pending errors without limit.
+	auto ReadErrors = [&](mlConvertJob* Job, bool Flush) -> void
+	{
+		QByteArray Chunk = Job->Process->readAllStandardError();
+		int Available = MaxErrorSize - Job->Errors.size();
+		if (Chunk.size() > Available)
+			Job->ErrorsTruncated = true;
+		Job->Errors.append(Chunk.left(Available));
+
+		QByteArray& Pending = Job->PendingErrors;
+		Pending.append(Chunk);
+
+		if (Job->SkippingErrorLine)
+		{
+			int LineEnd = Pending.indexOf('\n');
+			Pending.remove(0, (LineEnd == -1) ? Pending.size() : LineEnd + 1);
+			Job->SkippingErrorLine = (LineEnd == -1);
+		}
+
+		int ErrorCount = DiagnosticParser.ErrorCount();
+		int WarningCount = DiagnosticParser.WarningCount();
+
+		int ParseSize = Flush ? Pending.size() : Pending.lastIndexOf('\n') + 1;
+		if (ParseSize > 0)
+		{
+			for (const QByteArray& Line : Pending.left(ParseSize).split('\n'))
+				DiagnosticParser.ParseLine(QString::fromLocal8Bit(Line));
+			Pending.remove(0, ParseSize);
+		}
+
+		if (Pending.size() > MaxErrorSize)
+		{
+			DiagnosticParser.ParseLine(QString::fromLocal8Bit(Pending.left(MaxErrorSize)));
+			Pending.clear();
+			Job->SkippingErrorLine = true;
+		}
+
+		if (ErrorCount != DiagnosticParser.ErrorCount() || WarningCount != DiagnosticParser.WarningCount())
+			emit DiagnosticsUpdated(DiagnosticParser.ErrorCount(), DiagnosticParser.WarningCount());
+	};
+
+	auto FinishJob = [&](mlConvertJob* Job, int ExitCode, QProcess::ExitStatus ExitStatus) -> void
+	{
+		ReadOutput(Job);
+		ReadErrors(Job, true);
+
+		mlTraceEvent& Event = Job->Event;
+		Event.End = mTrace.Elapsed();
+		Event.ExitCode = (ExitStatus == QProcess::NormalExit) ? ExitCode : -1;
+		Event.Stats = Job->Probe.Collect();
+		LaneEvents[Event.Lane] = mTrace.AddEvent(Event);
+		LaneBusy[Event.Lane] = false;
+
+		QString Output = "Export2Bin: Converting '" + Job->Name + "'";
+		mlConvertStatus Status = ML_CONVERT_FAILED;
+
+		if (!Job->ExportStats.IsValid())
+		{
+			Output = "Export2Bin: '" + Job->Source.absoluteFilePath() + "' is not a valid export\n" + Job->ExportStats.Errors.join('\n');
+			convCountFailed++;
+
+			if (!mIgnoreErrors)
+			{
+				Success = false;
+				Stopping = true;
+			}
+		}
+		else if (ExitStatus != QProcess::NormalExit)
+		{
+			Output += "\nERROR: Process exited abnormally";
+			Success = false;
+			Stopping = true;
+		}
+		else if (ExitCode != 0)
+		{
+			Output += '\n' + QString::fromLocal8Bit(Job->Errors);
+			if (Job->ErrorsTruncated)
+				Output += "\n(error output truncated)";
+
+			convCountFailed++;
+
+			if (!mIgnoreErrors)
+			{
+				Success = false;
+				Stopping = true;
+			}
+		}
+		else if (!Job->WriteFailed && Job->Output->commit())
+		{
+			Manifest.SetEntry(Job->TargetFile, Job->Source, Job->InputHash.result().toHex(), ToolHash);
+			Status = ML_CONVERT_SUCCEEDED;
+			convCountSuccess++;
+		}
+		else
+		{
+			Output += "\nExport2Bin: Could not write '" + Job->TargetFile + "'\n";
+			convCountFailed++;
+		}
+
+		emit OutputReady(Output);
+		ReportFile(Job->Source.absoluteFilePath(), Status, Event.ExitCode, Job->BytesIn, Job->BytesOut, Event.End - Event.Start, Job->ExportStats.Summary());
+
+		Jobs.removeOne(Job);
+		Job->Process->disconnect();
+		Job->Process->deleteLater();
+		delete Job;
+
+		Schedule();
+	};
+
+	// Starts the next files until mMaxJobs are running, no new files are started after a failure unless errors are ignored
+	Schedule = [&]() -> void
+	{
+		while (!mCancel && !Stopping && Jobs.count() < mMaxJobs && NextFile < mFiles.count())
+		{
+			QFileInfo file_info(mFiles[NextFile++]);
+			QString file = file_info.baseName();
+			QString filepath = file_info.absoluteFilePath();
+
+			QString ext = file_info.suffix().toUpper();
+			if (ext == "XANIM_EXPORT")
+				ext = ".XANIM_BIN";
+			else if (ext == "XMODEL_EXPORT")
+				ext = ".XMODEL_BIN";
+			else
+			{
+				emit OutputReady("Export2Bin: Skipping file '" + filepath + "' (file has invalid extension)\n");
+				ReportFile(filepath, ML_CONVERT_SKIPPED, 0, file_info.size(), 0, 0, QString());
+				convCountSkipped++;
+				continue;
+			}
+
+			QString target_filepath = QDir::cleanPath(mOutputDir) + QDir::separator() + file + ext;
+
+			QStringList other_filepaths = TargetSources.value((file_info.baseName() + '.' + file_info.suffix()).toLower());
+			other_filepaths.removeAll(filepath);
+			if (!other_filepaths.isEmpty())
+			{
+				emit OutputReady("Export2Bin: Not converting '" + filepath + "', '" + other_filepaths.join("', '") + "' would be converted to the same '" + target_filepath + "'\n");
+				ReportFile(filepath, ML_CONVERT_FAILED, 0, file_info.size(), 0, 0, QString());
+				convCountFailed++;
+				continue;
+			}
+
+			QString other_filepath;
+			if (!Manifest.Claim(target_filepath, file_info, other_filepath))
+			{
+				emit OutputReady("Export2Bin: Not converting '" + filepath + "', '" + other_filepath + "' already converts to '" + target_filepath + "'\n");
+				ReportFile(filepath, ML_CONVERT_FAILED, 0, file_info.size(), 0, 0, QString());
+				convCountFailed++;
+				continue;
+			}
+
+			if (mOverwriteMode == ML_OVERWRITE_NEVER && QFile::exists(target_filepath))
+			{
+				emit OutputReady("Export2Bin: Skipping file '" + filepath + "' (file already exists)\n");
+				ReportFile(filepath, ML_CONVERT_SKIPPED, 0, file_info.size(), 0, 0, QString());
+				convCountSkipped++;
+				continue;
+			}
+
+			if (mOverwriteMode == ML_OVERWRITE_CHANGED && Manifest.IsUpToDate(target_filepath, file_info, ToolHash))
+			{
+				emit OutputReady("Export2Bin: Skipping file '" + filepath + "' (unchanged)\n");
+				ReportFile(filepath, ML_CONVERT_UNCHANGED, 0, file_info.size(), 0, 0, QString());
+				convCountUnchanged++;
+				continue;
+			}
+
+			mlConvertJob* Job = new mlConvertJob();
+			Job->Name = file;
+			Job->Source = file_info;
+			Job->TargetFile = target_filepath;
+
+			if (mPreflight)
+				Job->Validator = new mlExportParser(mlExportParser::TypeFromFileName(filepath));
+
+			Job->Input = new QFile(filepath);
+			if (!Job->Input->open(QIODevice::ReadOnly))
+			{
+				emit OutputReady("Export2Bin: Could not open '" + filepath + "' for reading\n");
+				ReportFile(filepath, ML_CONVERT_FAILED, 0, file_info.size(), 0, 0, QString());
+				convCountFailed++;
+				delete Job;
+				continue;
+			}
+
+			Job->Output = new QSaveFile(target_filepath);
+			if (!Job->Output->open(QIODevice::WriteOnly))
+			{
+				emit OutputReady("Export2Bin: Could not open '" + target_filepath + "' for writing\n");
+				ReportFile(filepath, ML_CONVERT_FAILED, 0, file_info.size(), 0, 0, QString());
+				convCountFailed++;
+				delete Job;
+				continue;
+			}
+
+			QProcess* Process = new QProcess();
+			Process->setWorkingDirectory(file_info.absolutePath());
+			Job->Process = Process;
+
+			mlTraceEvent& Event = Job->Event;
+			Event.Name = file;
+			Event.Category = "export2bin";
+			Event.Start = mTrace.Elapsed();
+			Event.Lane = LaneBusy.indexOf(false);
+			LaneBusy[Event.Lane] = true;
+
+			// Files converted one after another on the same job depend on each other for the critical path
+			if (LaneEvents[Event.Lane] != -1)
+				Event.Dependencies.append(LaneEvents[Event.Lane]);
+
+			connect(Process, &QProcess::readyReadStandardOutput, [&, Job]()
+			{
+				ReadOutput(Job);
+			});
+
+			connect(Process, &QProcess::readyReadStandardError, [&, Job]()
+			{
+				ReadErrors(Job, false);
+			});
+
+			connect(Process, &QProcess::bytesWritten, [&, Job]()
+			{
+				WriteInput(Job);
+			});
+
+			connect(Process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), [&, Job](int ExitCode, QProcess::ExitStatus ExitStatus)
+			{
+				FinishJob(Job, ExitCode, ExitStatus);
+			});
+
+			Process->start(mToolExecutable, mToolArguments);
+			if (!Process->waitForStarted(-1))
+			{
+				emit OutputReady(QString("ERROR: Could not start '%1'\n").arg(mToolExecutable));
+				LaneBusy[Event.Lane] = false;
+				delete Process;
+				delete Job;
+				Success = false;
+				Stopping = true;
+				break;
+			}
+
+			Job->Probe.Attach(Process->processId());
+			WriteInput(Job);
+
+			Jobs.append(Job);
+		}
+
+		if (Jobs.isEmpty())
+			EventLoop.quit();
+	};
+
+	// Cancel() is called from the UI thread, the processes have to be killed from the thread that owns them
+	QObject CancelContext;
+	connect(this, &mlConvertThread::CancelRequested, &CancelContext, [&]()
+	{
+		for (mlConvertJob* Job : Jobs)
+			Job->Process->kill();
+	});
+
+	Schedule();
+	if (!Jobs.isEmpty())
+		EventLoop.exec();
+
+	Manifest.Save();
+	mTrace.MarkCriticalPath();
+
+	mFailedCount = convCountFailed;
+	mSuccess = Success && !mCancel;
+	if (mSuccess)
+	{
+		QString msg = QString("Export2Bin: Finished!\n\n"
+			"Files Processed: %1\n"
+			"Successes: %2\n"
+			"Unchanged: %3\n"
+			"Skipped: %4\n"
+			"Failures: %5\n").arg(mFiles.count()).arg(convCountSuccess).arg(convCountUnchanged).arg(convCountSkipped).arg(convCountFailed);
+		emit OutputReady(msg);
+	}
+}
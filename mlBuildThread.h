@@ -0,0 +1,122 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+class mlBuildThread : public QThread
+{
+	Q_OBJECT
+
+public:
+	mlBuildThread(const mlBuildGraph& Graph, const mlBuildOptions& Options);
+	void run();
+	bool Succeeded() const
+	{
+		return mSuccess;
+	}
+
+	const mlBuildTrace& Trace() const
+	{
+		return mTrace;
+	}
+
+	void Cancel()
+	{
+		mCancel = true;
+		emit CancelRequested();
+	}
+
+signals:
+	void OutputReady(const QString& Output);
+	void DiagnosticsUpdated(int ErrorCount, int WarningCount);
+	void ProgressUpdated(int Percent, int RemainingSeconds);
+	void CancelRequested();
+	void ArtifactCopied(int StepIdx, bool Success);
+
+protected:
+	mlBuildGraph mGraph;
+	mlBuildOptions mOptions;
+	mlBuildTrace mTrace;
+	bool mSuccess;
+	volatile bool mCancel;
+};
+
+class mlConvertThread : public QThread
+{
+	Q_OBJECT
+
+public:
+	mlConvertThread(QStringList& Files, QString& OutputDir, bool IgnoreErrors, mlOverwriteMode OverwriteMode, int MaxJobs);
+	void run();
+	bool Succeeded() const
+	{
+		return mSuccess;
+	}
+
+	// Files that failed to convert, a conversion that ignores errors still succeeds when some fail
+	int FailedCount() const
+	{
+		return mFailedCount;
+	}
+
+	const mlBuildTrace& Trace() const
+	{
+		return mTrace;
+	}
+
+	void Cancel()
+	{
+		mCancel = true;
+		emit CancelRequested();
+	}
+
+	// Files that fail validation are reported without running export2bin
+	void SetPreflight(bool Preflight)
+	{
+		mPreflight = Preflight;
+	}
+
+	// Runs another tool in place of export2bin, it has to convert stdin to stdout the same way
+	void SetTool(const QString& Executable, const QStringList& Arguments)
+	{
+		mToolExecutable = Executable;
+		mToolArguments = Arguments;
+	}
+
+signals:
+	void OutputReady(const QString& Output);
+	void DiagnosticsUpdated(int ErrorCount, int WarningCount);
+	void ConvertStarted(int FileCount, int TotalKB);
+	void FileFinished(const QString& File, int Status, int ExitCode, int InputKB, int OutputKB, int Milliseconds, const QString& Assets);
+	void CancelRequested();
+
+protected:
+	QStringList mFiles;
+	QString mOutputDir;
+	QString mToolExecutable;
+	QStringList mToolArguments;
+	mlOverwriteMode mOverwriteMode;
+	int mMaxJobs;
+	bool mPreflight;
+	mlBuildTrace mTrace;
+
+	bool mSuccess;
+	bool mCancel;
+	bool mIgnoreErrors;
+	int mFailedCount;
+};
@@ -0,0 +1,317 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "stdafx.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+// The CPU time of a running process and of the children it waited for, from /proc/<pid>/stat. Like the high water
+// mark below it can't be read anymore once Qt has reaped the process.
+static bool GetProcessTimes(qint64 ProcessId, mlProcessStats& Stats)
+{
+	QFile StatFile(QString("/proc/%1/stat").arg(ProcessId));
+	if (!StatFile.open(QIODevice::ReadOnly))
+		return false;
+
+	// The command name can contain spaces, the fields are counted from the parenthesis that closes it
+	QByteArray Line = StatFile.readAll();
+	QList<QByteArray> Fields = Line.mid(Line.lastIndexOf(')') + 2).split(' ');
+	if (Fields.count() < 15)
+		return false;
+
+	const qint64 TicksPerSecond = qMax((qint64)sysconf(_SC_CLK_TCK), (qint64)1);
+	Stats.UserTime = (Fields[11].toLongLong() + Fields[13].toLongLong()) * 1000 / TicksPerSecond;
+	Stats.SystemTime = (Fields[12].toLongLong() + Fields[14].toLongLong()) * 1000 / TicksPerSecond;
+	return true;
+}
+
+static qint64 GetPeakMemory(qint64 ProcessId)
+{
+	QFile StatusFile(QString("/proc/%1/status").arg(ProcessId));
+	if (!StatusFile.open(QIODevice::ReadOnly))
+		return 0;
+
+	for (const QByteArray& Line : StatusFile.readAll().split('\n'))
+		if (Line.startsWith("VmHWM:"))
+			return Line.mid(6).simplified().split(' ').first().toLongLong() * 1024;
+
+	return 0;
+}
+#endif
+
+mlProcessStatsProbe::mlProcessStatsProbe()
+	: mHandle(NULL), mProcessId(0)
+{
+}
+
+mlProcessStatsProbe::~mlProcessStatsProbe()
+{
+#ifdef _WIN32
+	if (mHandle)
+		CloseHandle(mHandle);
+#endif
+}
+
+void mlProcessStatsProbe::Attach(qint64 ProcessId)
+{
+#ifdef _WIN32
+	// Holding a handle keeps the process times and memory counters around after QProcess has closed its own
+	if (!mHandle)
+		mHandle = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, (DWORD)ProcessId);
+#else
+	// Children are reaped by Qt before it reports that they finished, so their stats are sampled while they run
+	mProcessId = ProcessId;
+	Sample();
+#endif
+}
+
+// Reading /proc for every chunk of output would cost more than the step, so samples are at least 100 ms apart
+void mlProcessStatsProbe::Sample()
+{
+#ifndef _WIN32
+	if (mProcessId <= 0 || (mSampleTimer.isValid() && mSampleTimer.elapsed() < 100))
+		return;
+
+	mSampleTimer.start();
+
+	mlProcessStats Times;
+	if (GetProcessTimes(mProcessId, Times))
+	{
+		mSampled.UserTime = Times.UserTime;
+		mSampled.SystemTime = Times.SystemTime;
+	}
+
+	mSampled.PeakMemory = qMax(mSampled.PeakMemory, GetPeakMemory(mProcessId));
+#endif
+}
+
+mlProcessStats mlProcessStatsProbe::Collect()
+{
+	mlProcessStats Stats;
+
+#ifdef _WIN32
+	if (!mHandle)
+		return Stats;
+
+	FILETIME CreationTime, ExitTime, KernelTime, UserTime;
+	if (GetProcessTimes(mHandle, &CreationTime, &ExitTime, &KernelTime, &UserTime))
+	{
+		Stats.UserTime = (((qint64)UserTime.dwHighDateTime << 32) | UserTime.dwLowDateTime) / 10000;
+		Stats.SystemTime = (((qint64)KernelTime.dwHighDateTime << 32) | KernelTime.dwLowDateTime) / 10000;
+	}
+
+	PROCESS_MEMORY_COUNTERS Counters;
+	if (GetProcessMemoryInfo(mHandle, &Counters, sizeof(Counters)))
+		Stats.PeakMemory = Counters.PeakWorkingSetSize;
+
+	CloseHandle(mHandle);
+	mHandle = NULL;
+#else
+	// The process may still be around when its output is flushed before the exit is reported
+	mSampleTimer.invalidate();
+	Sample();
+
+	Stats = mSampled;
+	mProcessId = 0;
+#endif
+
+	return Stats;
+}
+
+// Stats of the launcher itself, the peak memory is the largest working set since it started
+mlProcessStats mlProcessStatsProbe::CurrentProcess()
+{
+	mlProcessStats Stats;
+
+#ifdef _WIN32
+	FILETIME CreationTime, ExitTime, KernelTime, UserTime;
+	if (GetProcessTimes(GetCurrentProcess(), &CreationTime, &ExitTime, &KernelTime, &UserTime))
+	{
+		Stats.UserTime = (((qint64)UserTime.dwHighDateTime << 32) | UserTime.dwLowDateTime) / 10000;
+		Stats.SystemTime = (((qint64)KernelTime.dwHighDateTime << 32) | KernelTime.dwLowDateTime) / 10000;
+	}
+
+	PROCESS_MEMORY_COUNTERS Counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &Counters, sizeof(Counters)))
+		Stats.PeakMemory = Counters.PeakWorkingSetSize;
+#else
+	struct rusage Usage;
+	getrusage(RUSAGE_SELF, &Usage);
+
+	Stats.UserTime = (qint64)Usage.ru_utime.tv_sec * 1000 + Usage.ru_utime.tv_usec / 1000;
+	Stats.SystemTime = (qint64)Usage.ru_stime.tv_sec * 1000 + Usage.ru_stime.tv_usec / 1000;
+	Stats.PeakMemory = (qint64)Usage.ru_maxrss * 1024;
+#endif
+
+	return Stats;
+}
+
+// Total installed memory in bytes, 0 when it can't be queried
+qint64 mlProcessStatsProbe::PhysicalMemory()
+{
+#ifdef _WIN32
+	MEMORYSTATUSEX Status;
+	Status.dwLength = sizeof(Status);
+	if (GlobalMemoryStatusEx(&Status))
+		return Status.ullTotalPhys;
+
+	return 0;
+#else
+	long Pages = sysconf(_SC_PHYS_PAGES);
+	long PageSize = sysconf(_SC_PAGE_SIZE);
+
+	return (Pages > 0 && PageSize > 0) ? (qint64)Pages * PageSize : 0;
+#endif
+}
+
+void mlBuildTrace::Start()
+{
+	mEvents.clear();
+	mTimer.start();
+}
+
+// Microseconds since Start()
+qint64 mlBuildTrace::Elapsed() const
+{
+	return mTimer.nsecsElapsed() / 1000;
+}
+
+int mlBuildTrace::AddEvent(const mlTraceEvent& Event)
+{
+	mEvents.append(Event);
+	return mEvents.count() - 1;
+}
+
+// Events are added as they finish, so the events a step depends on always come before it
+QList<int> mlBuildTrace::MarkCriticalPath()
+{
+	QVector<qint64> PathTime(mEvents.count(), 0);
+	QVector<int> PathPrevious(mEvents.count(), -1);
+	int LastEvent = -1;
+
+	for (int EventIdx = 0; EventIdx < mEvents.count(); EventIdx++)
+	{
+		mlTraceEvent& Event = mEvents[EventIdx];
+		Event.Critical = false;
+
+		for (int DependencyIdx : Event.Dependencies)
+		{
+			if (DependencyIdx < EventIdx && PathTime[DependencyIdx] > PathTime[EventIdx])
+			{
+				PathTime[EventIdx] = PathTime[DependencyIdx];
+				PathPrevious[EventIdx] = DependencyIdx;
+			}
+		}
+
+		PathTime[EventIdx] += Event.End - Event.Start;
+
+		if (LastEvent == -1 || PathTime[EventIdx] > PathTime[LastEvent])
+			LastEvent = EventIdx;
+	}
+
+	QList<int> Path;
+	for (int EventIdx = LastEvent; EventIdx != -1; EventIdx = PathPrevious[EventIdx])
+	{
+		mEvents[EventIdx].Critical = true;
+		Path.prepend(EventIdx);
+	}
+
+	return Path;
+}
+
+QString mlBuildTrace::Summary() const
+{
+	qint64 TotalTime = 0;
+	QStringList CriticalSteps;
+
+	for (const mlTraceEvent& Event : mEvents)
+	{
+		TotalTime = qMax(TotalTime, Event.End);
+
+		if (Event.Critical)
+			CriticalSteps << QString("%1 (%2s)").arg(Event.Name).arg((Event.End - Event.Start) / 1000000.0, 0, 'f', 1);
+	}
+
+	return QString("Finished in %1s, critical path: %2\n").arg(TotalTime / 1000000.0, 0, 'f', 1).arg(CriticalSteps.join(" -> "));
+}
+
+// Writes the events in the Chrome trace event format, which can be opened in chrome://tracing or Perfetto
+bool mlBuildTrace::Export(const QString& FileName) const
+{
+	QJsonArray TraceEvents;
+	QSet<int> Lanes;
+
+	for (const mlTraceEvent& Event : mEvents)
+	{
+		QJsonObject Args;
+		Args["exit_code"] = Event.ExitCode;
+		Args["user_ms"] = (double)Event.Stats.UserTime;
+		Args["system_ms"] = (double)Event.Stats.SystemTime;
+		Args["peak_memory_mb"] = Event.Stats.PeakMemory / (1024.0 * 1024.0);
+		Args["critical_path"] = Event.Critical;
+
+		QJsonObject TraceEvent;
+		TraceEvent["name"] = Event.Name;
+		TraceEvent["cat"] = Event.Category;
+		TraceEvent["ph"] = QString("X");
+		TraceEvent["ts"] = (double)Event.Start;
+		TraceEvent["dur"] = (double)(Event.End - Event.Start);
+		TraceEvent["pid"] = 1;
+		TraceEvent["tid"] = Event.Lane;
+		TraceEvent["args"] = Args;
+
+		if (Event.Critical)
+			TraceEvent["cname"] = QString("terrible");
+
+		TraceEvents.append(TraceEvent);
+		Lanes.insert(Event.Lane);
+	}
+
+	for (int Lane : Lanes)
+	{
+		QJsonObject Args;
+		Args["name"] = QString("Job %1").arg(Lane + 1);
+
+		QJsonObject Metadata;
+		Metadata["name"] = QString("thread_name");
+		Metadata["ph"] = QString("M");
+		Metadata["pid"] = 1;
+		Metadata["tid"] = Lane;
+		Metadata["args"] = Args;
+		TraceEvents.append(Metadata);
+	}
+
+	QJsonObject Root;
+	Root["traceEvents"] = TraceEvents;
+	Root["displayTimeUnit"] = QString("ms");
+
+	QFile File(FileName);
+	if (!File.open(QIODevice::WriteOnly))
+		return false;
+
+	File.write(QJsonDocument(Root).toJson(QJsonDocument::Compact));
+	return true;
+}
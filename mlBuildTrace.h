@@ -0,0 +1,100 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+struct mlProcessStats
+{
+	mlProcessStats()
+		: UserTime(0), SystemTime(0), PeakMemory(0)
+	{
+	}
+
+	qint64 UserTime;
+	qint64 SystemTime;
+	qint64 PeakMemory;
+};
+
+// Collects the CPU time and peak memory of a child process, Attach() must be called while the process is still running.
+// Where the stats of a child can't be queried after it exited, Sample() has to be called while it runs.
+class mlProcessStatsProbe
+{
+public:
+	mlProcessStatsProbe();
+	~mlProcessStatsProbe();
+
+	void Attach(qint64 ProcessId);
+	void Sample();
+	mlProcessStats Collect();
+
+	static mlProcessStats CurrentProcess();
+	static qint64 PhysicalMemory();
+
+protected:
+	Q_DISABLE_COPY(mlProcessStatsProbe)
+
+	void* mHandle;
+	qint64 mProcessId;
+	mlProcessStats mSampled;
+	QElapsedTimer mSampleTimer;
+};
+
+struct mlTraceEvent
+{
+	mlTraceEvent()
+		: Start(0), End(0), ExitCode(0), Lane(0), Critical(false)
+	{
+	}
+
+	QString Name;
+	QString Category;
+	qint64 Start;
+	qint64 End;
+	int ExitCode;
+	int Lane;
+	mlProcessStats Stats;
+	QList<int> Dependencies;
+	bool Critical;
+};
+
+class mlBuildTrace
+{
+public:
+	void Start();
+	qint64 Elapsed() const;
+
+	int AddEvent(const mlTraceEvent& Event);
+
+	bool IsEmpty() const
+	{
+		return mEvents.isEmpty();
+	}
+
+	const QList<mlTraceEvent>& Events() const
+	{
+		return mEvents;
+	}
+
+	QList<int> MarkCriticalPath();
+	QString Summary() const;
+	bool Export(const QString& FileName) const;
+
+protected:
+	QElapsedTimer mTimer;
+	QList<mlTraceEvent> mEvents;
+};
@@ -0,0 +1,884 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "stdafx.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+enum mlExitCode
+{
+	ML_EXIT_SUCCESS = 0,
+	ML_EXIT_FAILED = 1,
+	ML_EXIT_USAGE = 2
+};
+
+// Forwards the thread's output to stdout and the log until it finishes, each chunk of output is a line like in the output window
+template <typename ThreadType>
+static bool RunThread(ThreadType& Thread, QFile& Log)
+{
+	QEventLoop Loop;
+
+	QObject::connect(&Thread, &ThreadType::OutputReady, &Loop, [&](const QString& Output)
+	{
+		QByteArray Data = Output.toUtf8();
+		if (!Data.endsWith('\n'))
+			Data.append('\n');
+
+		fwrite(Data.constData(), 1, Data.size(), stdout);
+		fflush(stdout);
+
+		if (Log.isOpen())
+			Log.write(Data);
+	});
+	QObject::connect(&Thread, &QThread::finished, &Loop, &QEventLoop::quit);
+
+	Thread.start();
+	Loop.exec();
+	Thread.wait();
+
+	return Thread.Succeeded();
+}
+
+bool mlCommandLine::IsStubTool(int argc, char* argv[])
+{
+	return argc > 1 && !strcmp(argv[1], "--stub-tool");
+}
+
+// Stands in for one of the mod tools during benchmarks, the arguments are: --stub-tool <name> <runtime ms> <lines> <line length> <exit code> [-- <original arguments>]
+// It runs before any Qt application object is created so that its own startup cost stays negligible
+int mlCommandLine::RunStubTool(int argc, char* argv[])
+{
+	if (argc < 7)
+		return ML_EXIT_USAGE;
+
+	const int RuntimeMs = qMax(atoi(argv[3]), 0);
+	const int LineCount = qMax(atoi(argv[4]), 0);
+	const int LineLength = qMax(atoi(argv[5]), 1);
+	const int ExitCode = atoi(argv[6]);
+
+	// export2bin /piped converts stdin to stdout, the stub passes the data through unchanged
+	if (!strcmp(argv[2], "export2bin"))
+	{
+#ifdef _WIN32
+		_setmode(_fileno(stdin), _O_BINARY);
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+		std::vector<char> Buffer(64 * 1024);
+		size_t Size;
+
+		while ((Size = fread(&Buffer[0], 1, Buffer.size(), stdin)) > 0)
+			fwrite(&Buffer[0], 1, Size, stdout);
+		fflush(stdout);
+
+		QThread::msleep(RuntimeMs);
+		return ExitCode;
+	}
+
+	std::string Line = std::string(argv[2]) + ": ";
+	Line.resize(LineLength, '.');
+	Line += '\n';
+
+	// Output is spread over the runtime in a few bursts, like the real tools which print as they progress
+	const int SliceCount = qBound(1, LineCount, 10);
+
+	for (int SliceIdx = 0; SliceIdx < SliceCount; SliceIdx++)
+	{
+		int SliceLines = LineCount / SliceCount + ((SliceIdx < LineCount % SliceCount) ? 1 : 0);
+
+		for (int LineIdx = 0; LineIdx < SliceLines; LineIdx++)
+			fwrite(Line.data(), 1, Line.size(), stdout);
+		fflush(stdout);
+
+		QThread::msleep(RuntimeMs / SliceCount + ((SliceIdx == SliceCount - 1) ? RuntimeMs % SliceCount : 0));
+	}
+
+	return ExitCode;
+}
+
+bool mlCommandLine::IsCommandLineMode(int argc, char* argv[])
+{
+	for (int ArgIdx = 1; ArgIdx < argc; ArgIdx++)
+		if (!strcmp(argv[ArgIdx], "--build") || !strcmp(argv[ArgIdx], "--export2bin") || !strcmp(argv[ArgIdx], "--benchmark") || !strcmp(argv[ArgIdx], "--benchmark-export2bin"))
+			return true;
+
+	return false;
+}
+
+// The build benchmark shows its output in an output window, which needs a QApplication
+bool mlCommandLine::NeedsWidgets(int argc, char* argv[])
+{
+	for (int ArgIdx = 1; ArgIdx < argc; ArgIdx++)
+		if (!strcmp(argv[ArgIdx], "--benchmark"))
+			return true;
+
+	return false;
+}
+
+int mlCommandLine::Run(const QStringList& Arguments)
+{
+	AttachParentConsole();
+
+	if (Arguments.contains("--build"))
+		return RunBuild(Arguments);
+
+	if (Arguments.contains("--export2bin"))
+		return RunExport2Bin(Arguments);
+
+	if (Arguments.contains("--benchmark"))
+		return RunBenchmark(Arguments);
+
+	if (Arguments.contains("--benchmark-export2bin"))
+		return RunExport2BinBenchmark(Arguments);
+
+	return ML_EXIT_USAGE;
+}
+
+// The launcher is a GUI application, its output only shows up in the console it was started from when attached explicitly
+void mlCommandLine::AttachParentConsole()
+{
+#ifdef Q_OS_WIN
+	if (GetFileType(GetStdHandle(STD_OUTPUT_HANDLE)) == FILE_TYPE_UNKNOWN && AttachConsole(ATTACH_PARENT_PROCESS))
+	{
+		freopen("CONOUT$", "w", stdout);
+		freopen("CONOUT$", "w", stderr);
+	}
+#endif
+}
+
+// Logs go to the launcher's logs folder unless a file is given, the process id keeps concurrent builds from sharing a log
+bool mlCommandLine::OpenLog(QFile& Log, const QString& FileName)
+{
+	if (FileName.isEmpty())
+	{
+		QDir().mkpath("logs");
+		Log.setFileName(QString("logs/modlog_%1_%2.txt").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd_HH_mm_ss")).arg(QCoreApplication::applicationPid()));
+	}
+	else
+		Log.setFileName(FileName);
+
+	if (!Log.open(QIODevice::WriteOnly))
+	{
+		fprintf(stderr, "ERROR: Could not open log file '%s'\n", qPrintable(Log.fileName()));
+		return false;
+	}
+
+	return true;
+}
+
+// Builds maps and mods with the same steps as the Build button, without the main window or Steam
+int mlCommandLine::RunBuild(const QStringList& Arguments)
+{
+	QTextStream Out(stdout);
+
+	QCommandLineParser Parser;
+	Parser.setApplicationDescription("Builds maps and mods from the command line. Exits with 0 on success, 1 if the build failed and 2 if the command line is invalid.");
+	Parser.addPositionalArgument("items", "Maps and mods to build, a single zone of a mod can be given as mod/zone.", "<map|mod[/zone]>...");
+	QCommandLineOption BuildOption("build", "Build the given maps and mods.");
+	QCommandLineOption CompileOption("compile", "Compile maps.");
+	QCommandLineOption CompileEntsOption("compile-ents", "Compile only the entities of maps.");
+	QCommandLineOption LightOption("light", "Light maps.");
+	QCommandLineOption LightQualityOption("light-quality", "Light quality: low, medium or high.", "quality", "medium");
+	QCommandLineOption LinkOption("link", "Link maps and mods.");
+	QCommandLineOption LanguageOption("language", "Language to link, or All.", "language", "english");
+	QCommandLineOption JobsOption("jobs", "Number of tools to run at once.", "count", QString::number(QThread::idealThreadCount()));
+	QCommandLineOption MemoryBudgetOption("memory-budget", "Only start a step when the memory it used last time fits in this budget, 0 for no limit. Defaults to 3/4 of the installed memory.", "GB", QString::number(mlBuildProfiles::DefaultMemoryBudget()));
+	QCommandLineOption IgnoreErrorsOption("ignore-errors", "Keep building after a step fails.");
+	QCommandLineOption ForceRebuildOption("force-rebuild", "Run every step even if its inputs did not change.");
+	QCommandLineOption ForceUpdateDBOption("force-gdt-update", "Always run gdtdb /update.");
+	QCommandLineOption AbortOnFatalOption("abort-on-fatal", "Cancel the rest of the build on the first fatal tool error.");
+	QCommandLineOption ArtifactCacheOption("artifact-cache", "Folder where step outputs are shared between checkouts and machines.", "folder");
+	QCommandLineOption ArtifactCacheSizeOption("artifact-cache-size", "Size limit of the artifact cache.", "GB", "20");
+	QCommandLineOption LogOption("log", "Log file, defaults to logs/modlog_<date>_<pid>.txt.", "file");
+	QCommandLineOption TraceOption("trace", "Export the build timeline.", "file");
+	QCommandLineOption DryRunOption("dry-run", "Print the steps the build would run and how long they should take, without running them.");
+	Parser.addOption(BuildOption);
+	Parser.addOption(CompileOption);
+	Parser.addOption(CompileEntsOption);
+	Parser.addOption(LightOption);
+	Parser.addOption(LightQualityOption);
+	Parser.addOption(LinkOption);
+	Parser.addOption(LanguageOption);
+	Parser.addOption(JobsOption);
+	Parser.addOption(MemoryBudgetOption);
+	Parser.addOption(IgnoreErrorsOption);
+	Parser.addOption(ForceRebuildOption);
+	Parser.addOption(ForceUpdateDBOption);
+	Parser.addOption(AbortOnFatalOption);
+	Parser.addOption(ArtifactCacheOption);
+	Parser.addOption(ArtifactCacheSizeOption);
+	Parser.addOption(LogOption);
+	Parser.addOption(TraceOption);
+	Parser.addOption(DryRunOption);
+
+	if (!Parser.parse(Arguments))
+	{
+		Out << Parser.errorText() << endl << Parser.helpText();
+		return ML_EXIT_USAGE;
+	}
+
+	mlBuildOptions Options;
+	Options.Compile = Parser.isSet(CompileOption) || Parser.isSet(CompileEntsOption);
+	Options.CompileEntsOnly = Parser.isSet(CompileEntsOption);
+	Options.Light = Parser.isSet(LightOption);
+	Options.LightQuality = (QStringList() << "low" << "medium" << "high").indexOf(Parser.value(LightQualityOption).toLower());
+	Options.Link = Parser.isSet(LinkOption);
+	Options.Language = Parser.value(LanguageOption);
+	Options.ForceUpdateDB = Parser.isSet(ForceUpdateDBOption);
+	Options.IgnoreErrors = Parser.isSet(IgnoreErrorsOption);
+	Options.ForceRebuild = Parser.isSet(ForceRebuildOption);
+	Options.AbortOnFatalError = Parser.isSet(AbortOnFatalOption);
+	Options.MaxJobs = qMax(Parser.value(JobsOption).toInt(), 1);
+	Options.MemoryBudget = Parser.value(MemoryBudgetOption).toLongLong() * 1024 * 1024 * 1024;
+	Options.GamePath = QString(getenv("TA_GAME_PATH")).replace('\\', '/');
+	Options.ToolsPath = QString(getenv("TA_TOOLS_PATH")).replace('\\', '/');
+	Options.ArtifactCacheDir = Parser.value(ArtifactCacheOption);
+	Options.ArtifactCacheSize = Parser.value(ArtifactCacheSizeOption).toLongLong() * 1024 * 1024 * 1024;
+
+	if (Options.GamePath.isEmpty() || Options.ToolsPath.isEmpty())
+	{
+		Out << "ERROR: TA_GAME_PATH and TA_TOOLS_PATH must be set" << endl;
+		return ML_EXIT_USAGE;
+	}
+
+	if (Options.LightQuality == -1)
+	{
+		Out << QString("ERROR: Unknown light quality '%1'").arg(Parser.value(LightQualityOption)) << endl;
+		return ML_EXIT_USAGE;
+	}
+
+	QStringList Languages;
+	for (const char* Language : gLanguages)
+		Languages << Language;
+
+	if (Options.Language != "All" && !Languages.contains(Options.Language))
+	{
+		Out << QString("ERROR: Unknown language '%1', use one of %2 or All").arg(Options.Language, Languages.join(", ")) << endl;
+		return ML_EXIT_USAGE;
+	}
+
+	if (!Options.Compile && !Options.Light && !Options.Link)
+	{
+		Out << "ERROR: Nothing to do, use --compile, --compile-ents, --light or --link" << endl << Parser.helpText();
+		return ML_EXIT_USAGE;
+	}
+
+	// Items are found the same way the file list finds them, by their zone files
+	QList<mlBuildItem> Items;
+
+	for (const QString& ItemArgument : Parser.positionalArguments())
+	{
+		QString ItemName = ItemArgument.section('/', 0, 0);
+		QString ZoneName = ItemArgument.section('/', 1);
+		bool Found = false;
+
+		if (ZoneName.isEmpty() && QFileInfo(QString("%1/usermaps/%2/zone_source/%2.zone").arg(Options.GamePath, ItemName)).isFile())
+		{
+			Items.append(mlBuildItem(ML_ITEM_MAP, ItemName));
+			Found = true;
+		}
+		else
+		{
+			for (const char* ModZone : gModZones)
+			{
+				if ((ZoneName.isEmpty() || ZoneName == ModZone) && QFileInfo(QString("%1/mods/%2/zone_source/%3.zone").arg(Options.GamePath, ItemName, ModZone)).isFile())
+				{
+					Items.append(mlBuildItem(ML_ITEM_MOD, ItemName, ModZone));
+					Found = true;
+				}
+			}
+		}
+
+		if (!Found)
+		{
+			Out << QString("ERROR: '%1' is not a map or mod in %2").arg(ItemArgument, Options.GamePath) << endl;
+			return ML_EXIT_USAGE;
+		}
+	}
+
+	mlBuildGraph Graph = mlBuildGraph::Create(Items, Options);
+	if (Graph.IsEmpty())
+	{
+		Out << "ERROR: No maps or mods to build" << endl;
+		return ML_EXIT_USAGE;
+	}
+
+	if (Parser.isSet(DryRunOption))
+	{
+		mlBuildPlan Plan(Graph, Options);
+		const char* ActionNames[] = { "run", "restore", "up to date" };
+
+		for (int StepIdx = 0; StepIdx < Graph.Count(); StepIdx++)
+		{
+			const mlBuildStep& Step = Graph.Step(StepIdx);
+			Out << QString("%1 %2 %3s%4 %5 %6").arg(Step.Name, -40).arg(ActionNames[Plan.Action(StepIdx)], -10).arg(Plan.EstimatedDuration(StepIdx) / 1000, 6).arg(Plan.IsFallback(StepIdx) ? '?' : ' ')
+				.arg(Step.Executable, Step.Arguments.join(' ')) << endl;
+		}
+
+		if (Plan.HasHistory())
+			Out << QString("Estimated time: %1s").arg(Plan.EstimatedTotal() / 1000) << endl;
+		else
+			Out << QString("Estimated time: unknown, some steps have never been built (marked ?), going by other maps about %1s").arg(Plan.EstimatedTotal() / 1000) << endl;
+		return ML_EXIT_SUCCESS;
+	}
+
+	QFile Log;
+	if (!OpenLog(Log, Parser.value(LogOption)))
+		return ML_EXIT_FAILED;
+
+	mlBuildThread Thread(Graph, Options);
+	bool Success = RunThread(Thread, Log);
+
+	if (Parser.isSet(TraceOption))
+		Thread.Trace().Export(Parser.value(TraceOption));
+
+	return Success ? ML_EXIT_SUCCESS : ML_EXIT_FAILED;
+}
+
+// Converts model and animation exports with export2bin, folders are searched recursively for them
+int mlCommandLine::RunExport2Bin(const QStringList& Arguments)
+{
+	QTextStream Out(stdout);
+
+	QCommandLineParser Parser;
+	Parser.setApplicationDescription("Converts xmodel_export and xanim_export files. Exits with 0 on success, 1 if a conversion failed and 2 if the command line is invalid.");
+	Parser.addPositionalArgument("files", "Files and folders to convert.", "<file|folder>...");
+	QCommandLineOption Export2BinOption("export2bin", "Convert the given files.");
+	QCommandLineOption OutputOption("output", "Output folder, defaults to model_export/export2bin in the tools folder.", "folder");
+	QCommandLineOption OverwriteOption("overwrite", "Overwrite existing files.");
+	QCommandLineOption OnlyChangedOption("only-changed", "Only convert files whose source or export2bin changed since they were last converted.");
+	QCommandLineOption NoPreflightOption("no-preflight", "Do not validate the exports while export2bin converts them.");
+	QCommandLineOption IgnoreErrorsOption("ignore-errors", "Keep converting after a file fails.");
+	QCommandLineOption JobsOption("jobs", "Number of files to convert at once.", "count", QString::number(QThread::idealThreadCount()));
+	QCommandLineOption LogOption("log", "Log file, defaults to logs/modlog_<date>_<pid>.txt.", "file");
+	Parser.addOption(Export2BinOption);
+	Parser.addOption(OutputOption);
+	Parser.addOption(OverwriteOption);
+	Parser.addOption(OnlyChangedOption);
+	Parser.addOption(NoPreflightOption);
+	Parser.addOption(IgnoreErrorsOption);
+	Parser.addOption(JobsOption);
+	Parser.addOption(LogOption);
+
+	if (!Parser.parse(Arguments))
+	{
+		Out << Parser.errorText() << endl << Parser.helpText();
+		return ML_EXIT_USAGE;
+	}
+
+	// export2bin is run from the tools folder, so it is needed even when the output folder is given
+	QString ToolsPath = QDir::fromNativeSeparators(getenv("TA_TOOLS_PATH"));
+	if (ToolsPath.isEmpty())
+	{
+		Out << "ERROR: TA_TOOLS_PATH must be set" << endl;
+		return ML_EXIT_USAGE;
+	}
+
+	QString OutputDir = Parser.value(OutputOption);
+	if (OutputDir.isEmpty())
+		OutputDir = QString("%1/model_export/export2bin/").arg(ToolsPath);
+
+	if (!QDir().mkpath(OutputDir))
+	{
+		Out << QString("ERROR: Could not create output folder '%1'").arg(OutputDir) << endl;
+		return ML_EXIT_USAGE;
+	}
+
+	// Folders are expanded by the convert thread
+	QStringList Files = Parser.positionalArguments();
+	if (Files.isEmpty())
+	{
+		Out << "ERROR: No files to convert" << endl << Parser.helpText();
+		return ML_EXIT_USAGE;
+	}
+
+	QFile Log;
+	if (!OpenLog(Log, Parser.value(LogOption)))
+		return ML_EXIT_FAILED;
+
+	mlOverwriteMode OverwriteMode = ML_OVERWRITE_NEVER;
+	if (Parser.isSet(OnlyChangedOption))
+		OverwriteMode = ML_OVERWRITE_CHANGED;
+	else if (Parser.isSet(OverwriteOption))
+		OverwriteMode = ML_OVERWRITE_ALWAYS;
+
+	mlConvertThread Thread(Files, OutputDir, Parser.isSet(IgnoreErrorsOption), OverwriteMode, qMax(Parser.value(JobsOption).toInt(), 1));
+	Thread.SetPreflight(!Parser.isSet(NoPreflightOption));
+
+	bool Success = RunThread(Thread, Log);
+	return (Success && Thread.FailedCount() == 0) ? ML_EXIT_SUCCESS : ML_EXIT_FAILED;
+}
+
+// Builds a generated set of maps and mods with every tool replaced by a stub, so the numbers only reflect the launcher's own overhead:
+// graph construction, process scheduling, output forwarding and thread teardown. No game or tools install is needed.
+int mlCommandLine::RunBenchmark(const QStringList& Arguments)
+{
+	QTextStream Out(stdout);
+
+	QCommandLineParser Parser;
+	QCommandLineOption BenchmarkOption("benchmark", "Run the build pipeline benchmark.");
+	QCommandLineOption MapsOption("maps", "Number of maps to compile, light and link.", "count", "4");
+	QCommandLineOption ModsOption("mods", "Number of mod zones to link.", "count", "2");
+	QCommandLineOption JobsOption("jobs", "Number of tools to run at once.", "count", QString::number(QThread::idealThreadCount()));
+	QCommandLineOption IterationsOption("iterations", "Number of builds to run.", "count", "3");
+	QCommandLineOption RuntimeOption("runtime", "Time each stub tool runs for.", "ms", "200");
+	QCommandLineOption LinesOption("lines", "Lines of output printed by each stub tool.", "count", "1000");
+	QCommandLineOption LineLengthOption("line-length", "Length of each line of output.", "chars", "80");
+	QCommandLineOption LanguageOption("language", "Language to link, or All.", "language", "english");
+	QCommandLineOption FailOption("fail", "Make a tool (gdtdb, cod2map64, radiant_modtools, linker_modtools) exit with an error.", "tool");
+	QCommandLineOption MaxOutputLatencyOption("max-output-latency", "Fail when output waits longer than this to be shown in the output window.", "ms", "1000");
+	QCommandLineOption MaxEventLatencyOption("max-event-latency", "Fail when the output window keeps a posted event waiting longer than this.", "ms", "250");
+	QCommandLineOption TraceOption("trace", "Export the trace of the last build.", "file");
+	Parser.addOption(BenchmarkOption);
+	Parser.addOption(MapsOption);
+	Parser.addOption(ModsOption);
+	Parser.addOption(JobsOption);
+	Parser.addOption(IterationsOption);
+	Parser.addOption(RuntimeOption);
+	Parser.addOption(LinesOption);
+	Parser.addOption(LineLengthOption);
+	Parser.addOption(LanguageOption);
+	Parser.addOption(FailOption);
+	Parser.addOption(MaxOutputLatencyOption);
+	Parser.addOption(MaxEventLatencyOption);
+	Parser.addOption(TraceOption);
+
+	if (!Parser.parse(Arguments))
+	{
+		Out << Parser.errorText() << endl << Parser.helpText();
+		return ML_EXIT_USAGE;
+	}
+
+	const int MaxOutputLatency = Parser.value(MaxOutputLatencyOption).toInt();
+	const int MaxEventLatency = Parser.value(MaxEventLatencyOption).toInt();
+	const int RuntimeMs = Parser.value(RuntimeOption).toInt();
+	const int LineCount = Parser.value(LinesOption).toInt();
+	const int LineLength = Parser.value(LineLengthOption).toInt();
+	const int Iterations = qMax(Parser.value(IterationsOption).toInt(), 1);
+	const QStringList FailingTools = Parser.values(FailOption);
+
+	QTemporaryDir TempDir;
+	if (!TempDir.isValid())
+	{
+		Out << "ERROR: Could not create a temporary folder" << endl;
+		return ML_EXIT_FAILED;
+	}
+
+	mlBuildOptions Options;
+	Options.Compile = true;
+	Options.Light = true;
+	Options.LightQuality = 0;
+	Options.Link = true;
+	Options.Language = Parser.value(LanguageOption);
+	Options.ForceRebuild = true;
+	Options.MaxJobs = qMax(Parser.value(JobsOption).toInt(), 1);
+	Options.GamePath = TempDir.path() + "/game";
+	Options.ToolsPath = TempDir.path() + "/tools";
+
+	QList<mlBuildItem> Items;
+	for (int MapIdx = 0; MapIdx < Parser.value(MapsOption).toInt(); MapIdx++)
+		Items.append(mlBuildItem(ML_ITEM_MAP, QString("zm_bench%1").arg(MapIdx)));
+	for (int ModIdx = 0; ModIdx < Parser.value(ModsOption).toInt(); ModIdx++)
+		Items.append(mlBuildItem(ML_ITEM_MOD, QString("bench_mod%1").arg(ModIdx), "zm_mod"));
+
+	const int ConstructionRuns = 100;
+	mlBuildGraph Graph;
+	QElapsedTimer ConstructionTimer;
+	ConstructionTimer.start();
+
+	for (int RunIdx = 0; RunIdx < ConstructionRuns; RunIdx++)
+		Graph = mlBuildGraph::Create(Items, Options);
+
+	Out << QString("Graph construction: %1 steps in %2 ms").arg(Graph.Count()).arg(ConstructionTimer.nsecsElapsed() / 1000000.0 / ConstructionRuns, 0, 'f', 3) << endl;
+
+	// Same steps and dependencies, but every tool is this executable running as a stub
+	mlBuildGraph StubGraph;
+	for (int StepIdx = 0; StepIdx < Graph.Count(); StepIdx++)
+	{
+		const mlBuildStep& Step = Graph.Step(StepIdx);
+		QString ToolName = mlBuildProfiles::ToolName(Step);
+
+		QStringList Args;
+		Args << "--stub-tool" << ToolName << QString::number(RuntimeMs) << QString::number(LineCount) << QString::number(LineLength) << (FailingTools.contains(ToolName) ? "1" : "0") << "--" << Step.Arguments;
+
+		int StubStep = StubGraph.AddStep(Step.Name, QCoreApplication::applicationFilePath(), Args, Step.Dependencies);
+		StubGraph.SetFiles(StubStep, Step.Inputs, Step.Outputs);
+	}
+
+	double TotalWall = 0.0, TotalOverhead = 0.0, TotalGap = 0.0, TotalThroughput = 0.0;
+	bool ExpectedResults = true;
+
+	for (int Iteration = 0; Iteration < Iterations; Iteration++)
+	{
+		mlBuildThread Thread(StubGraph, Options);
+		QEventLoop Loop;
+		qint64 OutputChars = 0, OutputLines = 0;
+
+		// Output is shown in a real output window, and every 10 ms a zero timer is posted behind it to see how long the
+		// window keeps the rest of the UI waiting, like a click or a repaint would
+		mlOutputWidget OutputWidget;
+		OutputWidget.resize(800, 600);
+		OutputWidget.show();
+
+		QElapsedTimer EventClock;
+		QTimer EventTimer;
+		qint64 EventLatencyMax = 0;
+		EventClock.start();
+
+		QObject::connect(&EventTimer, &QTimer::timeout, &Loop, [&]()
+		{
+			const qint64 Posted = EventClock.elapsed();
+			QTimer::singleShot(0, &Loop, [&, Posted]()
+			{
+				EventLatencyMax = qMax(EventLatencyMax, EventClock.elapsed() - Posted);
+			});
+		});
+		EventTimer.start(10);
+
+		QObject::connect(&Thread, &mlBuildThread::OutputReady, &Loop, [&](const QString& Output)
+		{
+			OutputChars += Output.size();
+			OutputLines += Output.count('\n');
+			OutputWidget.AppendOutput(Output);
+		});
+		QObject::connect(&Thread, &QThread::finished, &Loop, &QEventLoop::quit);
+
+		QElapsedTimer Timer;
+		Timer.start();
+		Thread.start();
+		Loop.exec();
+		const qint64 Wall = Timer.nsecsElapsed() / 1000;
+
+		Thread.wait();
+
+		// Time between a step becoming runnable (its dependencies and its job slot are done) and its tool starting
+		const QList<mlTraceEvent>& Events = Thread.Trace().Events();
+		qint64 LastEnd = 0, CriticalWork = 0, GapTotal = 0, GapMax = 0;
+
+		for (const mlTraceEvent& Event : Events)
+		{
+			qint64 Ready = 0;
+
+			for (int DependencyIdx : Event.Dependencies)
+				Ready = qMax(Ready, Events[DependencyIdx].End);
+
+			for (const mlTraceEvent& Other : Events)
+				if (Other.Lane == Event.Lane && Other.End <= Event.Start)
+					Ready = qMax(Ready, Other.End);
+
+			GapTotal += Event.Start - Ready;
+			GapMax = qMax(GapMax, Event.Start - Ready);
+			LastEnd = qMax(LastEnd, Event.End);
+
+			if (Event.Critical)
+				CriticalWork += RuntimeMs * 1000;
+		}
+
+		const double GapAverage = Events.isEmpty() ? 0.0 : GapTotal / 1000.0 / Events.count();
+		const double Throughput = (OutputChars / (1024.0 * 1024.0)) / (Wall / 1000000.0);
+		const double Overhead = (Wall - CriticalWork) / 1000.0;
+
+		Out << QString("Build %1: wall %2 ms, overhead %3 ms over the critical path, gaps avg %4 ms max %5 ms, output %6 lines (%7 MB/s), finished %8 ms after the last step, %9")
+			.arg(Iteration + 1).arg(Wall / 1000.0, 0, 'f', 1).arg(Overhead, 0, 'f', 1).arg(GapAverage, 0, 'f', 2).arg(GapMax / 1000.0, 0, 'f', 2).arg(OutputLines).arg(Throughput, 0, 'f', 2)
+			.arg((Wall - LastEnd) / 1000.0, 0, 'f', 2).arg(Thread.Succeeded() ? "succeeded" : "failed") << endl;
+		const mlOutputQueue& PendingOutput = OutputWidget.PendingOutput();
+		Out << QString("Build %1: output window latency max %2 ms, posted event latency max %3 ms, %4 lines skipped").arg(Iteration + 1).arg(PendingOutput.MaxLatency()).arg(EventLatencyMax)
+			.arg(PendingOutput.SkippedLines()) << endl;
+
+		if (MaxOutputLatency > 0 && PendingOutput.MaxLatency() > MaxOutputLatency)
+		{
+			Out << QString("ERROR: Output waited %1 ms to be shown, the limit is %2 ms").arg(PendingOutput.MaxLatency()).arg(MaxOutputLatency) << endl;
+			ExpectedResults = false;
+		}
+
+		if (MaxEventLatency > 0 && EventLatencyMax > MaxEventLatency)
+		{
+			Out << QString("ERROR: A posted event waited %1 ms behind the output window, the limit is %2 ms").arg(EventLatencyMax).arg(MaxEventLatency) << endl;
+			ExpectedResults = false;
+		}
+
+		TotalWall += Wall / 1000.0;
+		TotalOverhead += Overhead;
+		TotalGap += GapAverage;
+		TotalThroughput += Throughput;
+
+		if (Thread.Succeeded() != FailingTools.isEmpty())
+			ExpectedResults = false;
+
+		if (Iteration == Iterations - 1 && Parser.isSet(TraceOption))
+			Thread.Trace().Export(Parser.value(TraceOption));
+	}
+
+	Out << QString("Average of %1 builds: wall %2 ms, overhead %3 ms, gaps %4 ms, output %5 MB/s").arg(Iterations).arg(TotalWall / Iterations, 0, 'f', 1).arg(TotalOverhead / Iterations, 0, 'f', 1)
+		.arg(TotalGap / Iterations, 0, 'f', 2).arg(TotalThroughput / Iterations, 0, 'f', 2) << endl;
+
+	return ExpectedResults ? ML_EXIT_SUCCESS : ML_EXIT_FAILED;
+}
+
+// Writes a well formed export of about the given size, a model made of vertices or an animation made of frames
+bool mlCommandLine::WriteSyntheticExport(const QString& FileName, qint64 Size)
+{
+	QFile File(FileName);
+	if (!File.open(QIODevice::WriteOnly))
+		return false;
+
+	const bool IsAnim = FileName.endsWith(".xanim_export", Qt::CaseInsensitive);
+
+	auto Record = [IsAnim](qint64 Idx) -> QByteArray
+	{
+		QString Offset = QString("OFFSET %1, %2, %3\n").arg((Idx % 1000) * 0.25, 0, 'f', 6).arg(-(Idx % 500) * 0.5, 0, 'f', 6).arg((Idx % 250) * 0.125, 0, 'f', 6);
+		if (IsAnim)
+			return (QString("FRAME %1\nPART 0\n").arg(Idx) + Offset + "X 1.000000, 0.000000, 0.000000\nY 0.000000, 1.000000, 0.000000\nZ 0.000000, 0.000000, 1.000000\n").toLatin1();
+		return (QString("VERT %1\n").arg(Idx) + Offset + "BONES 1\nBONE 0 1.000000\n").toLatin1();
+	};
+
+	QByteArray Header = "// Written by the Export2Bin benchmark\n";
+	if (IsAnim)
+		Header += "ANIMATION\nVERSION 3\n\nNUMPARTS 1\nPART 0 \"tag_origin\"\n\nFRAMERATE 30\n";
+	else
+		Header += "MODEL\nVERSION 7\n\nNUMBONES 1\nBONE 0 -1 \"tag_origin\"\n\nBONE 0\nOFFSET 0.000000, 0.000000, 0.000000\nSCALE 1.000000, 1.000000, 1.000000\n"
+			"X 1.000000, 0.000000, 0.000000\nY 0.000000, 1.000000, 0.000000\nZ 0.000000, 0.000000, 1.000000\n\n";
+
+	const qint64 RecordCount = qMax((Size - Header.size()) / Record(Size / 100).size(), (qint64)1);
+	Header += QString(IsAnim ? "NUMFRAMES %1\n\n" : "NUMVERTS %1\n").arg(RecordCount).toLatin1();
+
+	QByteArray Buffer = Header;
+	for (qint64 RecordIdx = 0; RecordIdx < RecordCount; RecordIdx++)
+	{
+		Buffer += Record(RecordIdx);
+
+		if (Buffer.size() >= 1024 * 1024)
+		{
+			if (File.write(Buffer) != Buffer.size())
+				return false;
+			Buffer.clear();
+		}
+	}
+
+	if (!IsAnim)
+		Buffer += "\nNUMFACES 0\n";
+
+	return File.write(Buffer) == Buffer.size();
+}
+
+// Converts a generated corpus of model and animation exports with export2bin replaced by a stub that copies its input,
+// so the numbers only reflect the launcher's own cost of starting processes and moving the data through them
+int mlCommandLine::RunExport2BinBenchmark(const QStringList& Arguments)
+{
+	QTextStream Out(stdout);
+
+	QCommandLineParser Parser;
+	Parser.setApplicationDescription("Measures the Export2Bin pipeline against a stub export2bin. Exits with 0 if every conversion produced the expected file within the time limit.");
+	QCommandLineOption BenchmarkOption("benchmark-export2bin", "Run the Export2Bin benchmark.");
+	QCommandLineOption FilesOption("files", "Number of exports to generate.", "count", "200");
+	QCommandLineOption MinSizeOption("min-size", "Size of the smallest export.", "KB", "16");
+	QCommandLineOption MaxSizeOption("max-size", "Size of the largest export, sizes in between grow geometrically.", "KB", "65536");
+	QCommandLineOption CorpusOption("corpus", "Convert the exports in this folder instead of generating them.", "folder");
+	QCommandLineOption JobsOption("jobs", "Number of files to convert at once.", "count", QString::number(QThread::idealThreadCount()));
+	QCommandLineOption IterationsOption("iterations", "Number of conversions to run.", "count", "3");
+	QCommandLineOption RuntimeOption("runtime", "Time the stub waits after copying each file.", "ms", "0");
+	QCommandLineOption OnlyChangedOption("only-changed", "Convert with 'Only if Changed', every conversion after the first measures the manifest check.");
+	QCommandLineOption NoPreflightOption("no-preflight", "Do not validate the exports while converting them.");
+	QCommandLineOption MaxPerFileOption("max-ms-per-file", "Fail when a file spends longer than this in the pipeline on average, 0 for no limit.", "ms", "0");
+	QCommandLineOption TraceOption("trace", "Export the trace of the last conversion.", "file");
+	Parser.addOption(BenchmarkOption);
+	Parser.addOption(FilesOption);
+	Parser.addOption(MinSizeOption);
+	Parser.addOption(MaxSizeOption);
+	Parser.addOption(CorpusOption);
+	Parser.addOption(JobsOption);
+	Parser.addOption(IterationsOption);
+	Parser.addOption(RuntimeOption);
+	Parser.addOption(OnlyChangedOption);
+	Parser.addOption(NoPreflightOption);
+	Parser.addOption(MaxPerFileOption);
+	Parser.addOption(TraceOption);
+
+	if (!Parser.parse(Arguments))
+	{
+		Out << Parser.errorText() << endl << Parser.helpText();
+		return ML_EXIT_USAGE;
+	}
+
+	const int Iterations = qMax(Parser.value(IterationsOption).toInt(), 1);
+	const int Jobs = qMax(Parser.value(JobsOption).toInt(), 1);
+	const double MaxPerFile = Parser.value(MaxPerFileOption).toDouble();
+
+	QTemporaryDir TempDir;
+	if (!TempDir.isValid())
+	{
+		Out << "ERROR: Could not create a temporary folder" << endl;
+		return ML_EXIT_FAILED;
+	}
+
+	QString CorpusDir = Parser.value(CorpusOption);
+	if (CorpusDir.isEmpty())
+	{
+		CorpusDir = TempDir.path() + "/corpus";
+		QDir().mkpath(CorpusDir);
+
+		const int FileCount = qMax(Parser.value(FilesOption).toInt(), 1);
+		const double MinSize = qMax(Parser.value(MinSizeOption).toDouble(), 1.0) * 1024;
+		const double MaxSize = qMax(Parser.value(MaxSizeOption).toDouble() * 1024, MinSize);
+
+		QElapsedTimer GenerateTimer;
+		GenerateTimer.start();
+		qint64 CorpusSize = 0;
+
+		for (int FileIdx = 0; FileIdx < FileCount; FileIdx++)
+		{
+			double Fraction = (FileCount > 1) ? (double)FileIdx / (FileCount - 1) : 0.0;
+			qint64 Size = (qint64)(MinSize * qPow(MaxSize / MinSize, Fraction));
+			QString FileName = QString((FileIdx % 2) ? "%1/bench_anim_%2.xanim_export" : "%1/bench_model_%2.xmodel_export").arg(CorpusDir).arg(FileIdx, 4, 10, QChar('0'));
+
+			if (!WriteSyntheticExport(FileName, Size))
+			{
+				Out << QString("ERROR: Could not write '%1'").arg(FileName) << endl;
+				return ML_EXIT_FAILED;
+			}
+
+			CorpusSize += Size;
+		}
+
+		Out << QString("Generated %1 exports, %2 MB in %3 s").arg(FileCount).arg(CorpusSize / (1024.0 * 1024.0), 0, 'f', 1).arg(GenerateTimer.elapsed() / 1000.0, 0, 'f', 1) << endl;
+	}
+
+	QStringList Files;
+	qint64 InputSize = 0;
+
+	QDirIterator It(CorpusDir, QStringList() << "*.xmodel_export" << "*.xanim_export", QDir::Files, QDirIterator::Subdirectories);
+	while (It.hasNext())
+	{
+		Files << It.next();
+		InputSize += It.fileInfo().size();
+	}
+
+	if (Files.isEmpty())
+	{
+		Out << QString("ERROR: No exports in '%1'").arg(CorpusDir) << endl;
+		return ML_EXIT_USAGE;
+	}
+
+	// Preflight validation on its own, the files were just written or listed so they are likely to be in the file cache
+	QElapsedTimer ParseTimer;
+	ParseTimer.start();
+	int InvalidCount = 0;
+
+	for (const QString& File : Files)
+	{
+		mlExportStats Stats = mlExportParser::ParseFile(File);
+		if (!Stats.IsValid())
+		{
+			if (!InvalidCount++)
+				Out << QString("'%1' is not a valid export: %2").arg(File).arg(Stats.Errors.join(", ")) << endl;
+		}
+	}
+
+	const double ParseSeconds = qMax(ParseTimer.nsecsElapsed(), (qint64)1) / 1000000000.0;
+	Out << QString("Validated %1 exports, %2 MB in %3 ms (%4 GB/s), %5 invalid").arg(Files.count()).arg(InputSize / (1024.0 * 1024.0), 0, 'f', 1).arg(ParseSeconds * 1000.0, 0, 'f', 1)
+		.arg(InputSize / (1024.0 * 1024.0 * 1024.0) / ParseSeconds, 0, 'f', 2).arg(InvalidCount) << endl;
+
+	QString OutputDir = TempDir.path() + "/output";
+	QDir().mkpath(OutputDir);
+
+	QStringList StubArgs;
+	StubArgs << "--stub-tool" << "export2bin" << QString::number(qMax(Parser.value(RuntimeOption).toInt(), 0)) << "0" << "1" << "0" << "--" << "/piped";
+
+	const qint64 BaselineMemory = mlProcessStatsProbe::CurrentProcess().PeakMemory;
+	double TotalFilesPerSecond = 0.0, TotalThroughput = 0.0, TotalPerFile = 0.0;
+	bool ExpectedResults = true;
+
+	for (int Iteration = 0; Iteration < Iterations; Iteration++)
+	{
+		mlConvertThread Thread(Files, OutputDir, false, Parser.isSet(OnlyChangedOption) ? ML_OVERWRITE_CHANGED : ML_OVERWRITE_ALWAYS, Jobs);
+		Thread.SetTool(QCoreApplication::applicationFilePath(), StubArgs);
+		Thread.SetPreflight(!Parser.isSet(NoPreflightOption));
+
+		QEventLoop Loop;
+		QObject::connect(&Thread, &QThread::finished, &Loop, &QEventLoop::quit);
+
+		QElapsedTimer Timer;
+		Timer.start();
+		Thread.start();
+		Loop.exec();
+		const qint64 Wall = Timer.nsecsElapsed() / 1000;
+
+		Thread.wait();
+
+		// Time a file spends in the pipeline, from its job slot freeing up to its output being committed
+		const QList<mlTraceEvent>& Events = Thread.Trace().Events();
+		qint64 PerFileTotal = 0;
+		QVector<qint64> LaneEnds(Jobs, 0);
+
+		for (const mlTraceEvent& Event : Events)
+		{
+			PerFileTotal += Event.End - qMin(LaneEnds[Event.Lane], Event.Start);
+			LaneEnds[Event.Lane] = Event.End;
+		}
+
+		const double Seconds = Wall / 1000000.0;
+		const double FilesPerSecond = Files.count() / Seconds;
+		const double Throughput = Events.isEmpty() ? 0.0 : (InputSize / (1024.0 * 1024.0)) / Seconds;
+		const double PerFile = Events.isEmpty() ? 0.0 : PerFileTotal / 1000.0 / Events.count();
+		const qint64 PeakMemory = mlProcessStatsProbe::CurrentProcess().PeakMemory;
+
+		Out << QString("Conversion %1: wall %2 ms, %3 files/s, %4 MB/s, %5 ms per file, %6 converted, peak launcher memory %7 MB (%8 MB before converting), %9")
+			.arg(Iteration + 1).arg(Wall / 1000.0, 0, 'f', 1).arg(FilesPerSecond, 0, 'f', 1).arg(Throughput, 0, 'f', 1).arg(PerFile, 0, 'f', 2).arg(Events.count())
+			.arg(PeakMemory / (1024.0 * 1024.0), 0, 'f', 1).arg(BaselineMemory / (1024.0 * 1024.0), 0, 'f', 1).arg(Thread.Succeeded() ? "succeeded" : "failed") << endl;
+
+		TotalFilesPerSecond += FilesPerSecond;
+		TotalThroughput += Throughput;
+		TotalPerFile += PerFile;
+
+		if (!Thread.Succeeded())
+			ExpectedResults = false;
+
+		// The stub copies its input, so every output has to be exactly as large as its export
+		if (Iteration == 0)
+		{
+			for (const QString& File : Files)
+			{
+				QFileInfo FileInfo(File);
+				QString Extension = FileInfo.suffix().compare("xanim_export", Qt::CaseInsensitive) ? ".XMODEL_BIN" : ".XANIM_BIN";
+				if (QFileInfo(OutputDir + "/" + FileInfo.baseName() + Extension).size() != FileInfo.size())
+				{
+					Out << QString("ERROR: Output of '%1' does not match its export").arg(File) << endl;
+					ExpectedResults = false;
+				}
+			}
+		}
+
+		if (Iteration == Iterations - 1 && Parser.isSet(TraceOption))
+			Thread.Trace().Export(Parser.value(TraceOption));
+	}
+
+	Out << QString("Average of %1 conversions: %2 files/s, %3 MB/s, %4 ms per file").arg(Iterations).arg(TotalFilesPerSecond / Iterations, 0, 'f', 1)
+		.arg(TotalThroughput / Iterations, 0, 'f', 1).arg(TotalPerFile / Iterations, 0, 'f', 2) << endl;
+
+	// The average over every conversion, so a single slow run on a busy machine doesn't fail the benchmark
+	if (MaxPerFile > 0.0 && TotalPerFile / Iterations > MaxPerFile)
+	{
+		Out << QString("ERROR: Files took %1 ms each on average, the limit is %2 ms").arg(TotalPerFile / Iterations, 0, 'f', 2).arg(MaxPerFile, 0, 'f', 2) << endl;
+		ExpectedResults = false;
+	}
+
+	return ExpectedResults ? ML_EXIT_SUCCESS : ML_EXIT_FAILED;
+}
@@ -0,0 +1,40 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+// Modes that run without creating the main window or initializing Steam
+class mlCommandLine
+{
+public:
+	static bool IsStubTool(int argc, char* argv[]);
+	static int RunStubTool(int argc, char* argv[]);
+
+	static bool IsCommandLineMode(int argc, char* argv[]);
+	static bool NeedsWidgets(int argc, char* argv[]);
+	static int Run(const QStringList& Arguments);
+
+protected:
+	static void AttachParentConsole();
+	static bool OpenLog(QFile& Log, const QString& FileName);
+	static int RunBuild(const QStringList& Arguments);
+	static int RunExport2Bin(const QStringList& Arguments);
+	static int RunBenchmark(const QStringList& Arguments);
+	static int RunExport2BinBenchmark(const QStringList& Arguments);
+	static bool WriteSyntheticExport(const QString& FileName, qint64 Size);
+};
@@ -0,0 +1,163 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "stdafx.h"
+
+mlConvertManifest::mlConvertManifest(const QString& OutputDir)
+	: mFileName(FileName(OutputDir)), mDirty(false)
+{
+}
+
+QString mlConvertManifest::FileName(const QString& OutputDir)
+{
+	return QDir::cleanPath(OutputDir) + "/export2bin_manifest.json";
+}
+
+QByteArray mlConvertManifest::HashFile(const QString& FileName)
+{
+	QFile File(FileName);
+	if (!File.open(QIODevice::ReadOnly))
+		return QByteArray();
+
+	QCryptographicHash Hash(QCryptographicHash::Sha1);
+	Hash.addData(&File);
+	return Hash.result().toHex();
+}
+
+bool mlConvertManifest::Load()
+{
+	QFile File(mFileName);
+	if (!File.open(QIODevice::ReadOnly))
+		return false;
+
+	QJsonObject Files = QJsonDocument::fromJson(File.readAll()).object()["Files"].toObject();
+	for (QJsonObject::const_iterator It = Files.constBegin(); It != Files.constEnd(); ++It)
+	{
+		QJsonObject FileObject = It.value().toObject();
+
+		mlConvertEntry Entry;
+		Entry.Source = FileObject["Source"].toString();
+		Entry.Size = (qint64)FileObject["Size"].toDouble();
+		Entry.Modified = (qint64)FileObject["Modified"].toDouble();
+		Entry.Hash = FileObject["Hash"].toString().toLatin1();
+		Entry.Tool = FileObject["Tool"].toString().toLatin1();
+		mEntries.insert(EntryKey(It.key()), Entry);
+	}
+
+	mDirty = false;
+	return true;
+}
+
+bool mlConvertManifest::Save()
+{
+	if (!mDirty)
+		return true;
+
+	QJsonObject Files;
+	for (QHash<QString, mlConvertEntry>::const_iterator It = mEntries.constBegin(); It != mEntries.constEnd(); ++It)
+	{
+		QJsonObject FileObject;
+		FileObject["Source"] = It->Source;
+		FileObject["Size"] = (double)It->Size;
+		FileObject["Modified"] = (double)It->Modified;
+		FileObject["Hash"] = QString::fromLatin1(It->Hash);
+		FileObject["Tool"] = QString::fromLatin1(It->Tool);
+		Files[It.key()] = FileObject;
+	}
+
+	QJsonObject Root;
+	Root["Files"] = Files;
+
+	QSaveFile File(mFileName);
+	if (!File.open(QIODevice::WriteOnly))
+		return false;
+
+	File.write(QJsonDocument(Root).toJson(QJsonDocument::Indented));
+	if (!File.commit())
+		return false;
+
+	mDirty = false;
+	return true;
+}
+
+// Output folders are on Windows, so file names that only differ in case are the same target
+QString mlConvertManifest::EntryKey(const QString& TargetFile)
+{
+	return QFileInfo(TargetFile).fileName().toLower();
+}
+
+// Two sources with the same base name in different folders would write the same target, only the first one to claim
+// it in a run is converted so the entry and the file always come from the same source
+bool mlConvertManifest::Claim(const QString& TargetFile, const QFileInfo& SourceInfo, QString& OtherSource)
+{
+	QString Key = EntryKey(TargetFile);
+	QString Source = SourceInfo.absoluteFilePath();
+
+	QHash<QString, QString>::const_iterator It = mClaims.constFind(Key);
+	if (It != mClaims.constEnd() && It->compare(Source, Qt::CaseInsensitive))
+	{
+		OtherSource = *It;
+		return false;
+	}
+
+	mClaims.insert(Key, Source);
+	return true;
+}
+
+// The source is only hashed again when its size or modification time changed, a touched but identical file still counts as unchanged
+bool mlConvertManifest::IsUpToDate(const QString& TargetFile, const QFileInfo& SourceInfo, const QByteArray& ToolHash)
+{
+	QHash<QString, mlConvertEntry>::iterator It = mEntries.find(EntryKey(TargetFile));
+	if (It == mEntries.end() || !QFile::exists(TargetFile))
+		return false;
+
+	if (It->Source.compare(SourceInfo.absoluteFilePath(), Qt::CaseInsensitive) || It->Tool != ToolHash)
+		return false;
+
+	qint64 Modified = SourceInfo.lastModified().toMSecsSinceEpoch();
+	if (It->Size == SourceInfo.size() && It->Modified == Modified)
+		return true;
+
+	if (It->Hash != HashFile(SourceInfo.absoluteFilePath()))
+		return false;
+
+	It->Size = SourceInfo.size();
+	It->Modified = Modified;
+	mDirty = true;
+
+	return true;
+}
+
+void mlConvertManifest::SetEntry(const QString& TargetFile, const QFileInfo& SourceInfo, const QByteArray& SourceHash, const QByteArray& ToolHash)
+{
+	mlConvertEntry Entry;
+	Entry.Source = SourceInfo.absoluteFilePath();
+	Entry.Size = SourceInfo.size();
+	Entry.Modified = SourceInfo.lastModified().toMSecsSinceEpoch();
+	Entry.Hash = SourceHash;
+	Entry.Tool = ToolHash;
+
+	mEntries.insert(EntryKey(TargetFile), Entry);
+	mDirty = true;
+}
+
+void mlConvertManifest::RemoveEntry(const QString& TargetFile)
+{
+	if (mEntries.remove(EntryKey(TargetFile)))
+		mDirty = true;
+}
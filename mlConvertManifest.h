@@ -0,0 +1,70 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+enum mlOverwriteMode
+{
+	ML_OVERWRITE_ALWAYS,
+	ML_OVERWRITE_NEVER,
+	ML_OVERWRITE_CHANGED
+};
+
+enum mlConvertStatus
+{
+	ML_CONVERT_SUCCEEDED,
+	ML_CONVERT_FAILED,
+	ML_CONVERT_SKIPPED,
+	ML_CONVERT_UNCHANGED
+};
+
+// Records the source and the export2bin build that produced each file in an Export2Bin output folder, so files are
+// only converted again when one of them changed
+class mlConvertManifest
+{
+public:
+	mlConvertManifest(const QString& OutputDir);
+
+	static QString FileName(const QString& OutputDir);
+	static QByteArray HashFile(const QString& FileName);
+
+	bool Load();
+	bool Save();
+
+	bool Claim(const QString& TargetFile, const QFileInfo& SourceInfo, QString& OtherSource);
+	bool IsUpToDate(const QString& TargetFile, const QFileInfo& SourceInfo, const QByteArray& ToolHash);
+	void SetEntry(const QString& TargetFile, const QFileInfo& SourceInfo, const QByteArray& SourceHash, const QByteArray& ToolHash);
+	void RemoveEntry(const QString& TargetFile);
+
+protected:
+	static QString EntryKey(const QString& TargetFile);
+
+	struct mlConvertEntry
+	{
+		QString Source;
+		qint64 Size;
+		qint64 Modified;
+		QByteArray Hash;
+		QByteArray Tool;
+	};
+
+	QString mFileName;
+	QHash<QString, mlConvertEntry> mEntries;
+	QHash<QString, QString> mClaims;
+	bool mDirty;
+};
@@ -0,0 +1,34 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+// Everything the build, the conversion and the command line modes need, without the main window or the Steam SDK
+#include <QtCore/QtCore>
+#include "mlBuildGraph.h"
+#include "mlBuildCache.h"
+#include "mlConvertManifest.h"
+#include "mlBuildTrace.h"
+#include "mlBuildProfiles.h"
+#include "mlBuildPlan.h"
+#include "mlCommandLine.h"
+#include "mlDiagnostics.h"
+#include "mlExportParser.h"
+#include "mlFileScanner.h"
+#include "mlLogWriter.h"
+#include "mlBuildThread.h"
@@ -0,0 +1,98 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "stdafx.h"
+
+mlDiagnosticParser::mlDiagnosticParser()
+	: mColorCode("\\^\\d"), mError(ErrorPattern(), QRegularExpression::CaseInsensitiveOption), mWarning("\\bwarning\\b\\s*[:!-]", QRegularExpression::CaseInsensitiveOption),
+	mFatal("^\\s*(?:\\*+\\s*)?(?:[\\w.]+\\s*:\\s*)?(?:fatal(?:\\s+error)?|error\\s*:\\s*fatal)\\b", QRegularExpression::CaseInsensitiveOption),
+	mAsset("\\b(xmodel|xanim|material|image|fx|sound|weapon|techset|xcam|rawfile|scriptbundle|stringtable|localize)\\b\\s*['\"]([^'\"]+)['\"]", QRegularExpression::CaseInsensitiveOption),
+	mMissing("\\b(?:missing|could not (?:find|load|open)|couldn't (?:find|load|open)|cannot (?:find|load|open)|unable to (?:find|load|open))\\b", QRegularExpression::CaseInsensitiveOption),
+	mProgress("(\\d{1,3})\\s*%"), mErrorCount(0), mWarningCount(0)
+{
+}
+
+// Also used by the output window to jump between errors
+QString mlDiagnosticParser::ErrorPattern()
+{
+	return "\\b(?:error|fatal)\\b\\s*[:!-]";
+}
+
+mlDiagnostic mlDiagnosticParser::ParseLine(const QString& Line)
+{
+	mlDiagnostic Diagnostic;
+
+	// Some tools prefix lines with console color codes such as ^1
+	QString Text = Line;
+	if (Text.contains('^'))
+		Text.remove(mColorCode);
+
+	QRegularExpressionMatch AssetMatch = mAsset.match(Text);
+	if (AssetMatch.hasMatch())
+	{
+		Diagnostic.AssetType = AssetMatch.captured(1).toLower();
+		Diagnostic.Asset = AssetMatch.captured(2);
+		Diagnostic.Missing = mMissing.match(Text).hasMatch();
+
+		QString Name = QString("%1 '%2'").arg(Diagnostic.AssetType, Diagnostic.Asset);
+		mReferencedAssets.insert(Name);
+		if (Diagnostic.Missing)
+			mMissingAssets.insert(Name);
+	}
+
+	if (mError.match(Text).hasMatch())
+	{
+		// Only errors the tools themselves report as fatal count, e.g. 'Fatal Error: ...' or 'linker: ERROR: fatal ...'.
+		// A missing asset on its own is often recoverable and must not abort the build.
+		Diagnostic.Type = ML_DIAGNOSTIC_ERROR;
+		Diagnostic.Fatal = mFatal.match(Text).hasMatch();
+		mErrorCount++;
+	}
+	else if (mWarning.match(Text).hasMatch())
+	{
+		Diagnostic.Type = ML_DIAGNOSTIC_WARNING;
+		mWarningCount++;
+	}
+	else if (!Diagnostic.Asset.isEmpty())
+		Diagnostic.Type = ML_DIAGNOSTIC_ASSET;
+	else
+	{
+		QRegularExpressionMatch ProgressMatch = mProgress.match(Text);
+		if (ProgressMatch.hasMatch())
+		{
+			Diagnostic.Type = ML_DIAGNOSTIC_PROGRESS;
+			Diagnostic.Progress = qMin(ProgressMatch.captured(1).toInt(), 100);
+		}
+	}
+
+	return Diagnostic;
+}
+
+QStringList mlDiagnosticParser::ReferencedAssets() const
+{
+	QStringList Assets = mReferencedAssets.toList();
+	Assets.sort();
+	return Assets;
+}
+
+QStringList mlDiagnosticParser::MissingAssets() const
+{
+	QStringList Assets = mMissingAssets.toList();
+	Assets.sort();
+	return Assets;
+}
@@ -0,0 +1,81 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+enum mlDiagnosticType
+{
+	ML_DIAGNOSTIC_NONE,
+	ML_DIAGNOSTIC_ERROR,
+	ML_DIAGNOSTIC_WARNING,
+	ML_DIAGNOSTIC_PROGRESS,
+	ML_DIAGNOSTIC_ASSET
+};
+
+struct mlDiagnostic
+{
+	mlDiagnostic()
+		: Type(ML_DIAGNOSTIC_NONE), Fatal(false), Progress(-1), Missing(false)
+	{
+	}
+
+	mlDiagnosticType Type;
+	bool Fatal;
+	int Progress;
+	QString AssetType;
+	QString Asset;
+	bool Missing;
+};
+
+// Classifies the output of cod2map64, radiant, the linker and export2bin one line at a time as it streams in
+class mlDiagnosticParser
+{
+public:
+	mlDiagnosticParser();
+
+	mlDiagnostic ParseLine(const QString& Line);
+
+	int ErrorCount() const
+	{
+		return mErrorCount;
+	}
+
+	int WarningCount() const
+	{
+		return mWarningCount;
+	}
+
+	// Assets named in the output as "<type> '<name>'", sorted. Missing ones are those the tools could not find or load.
+	QStringList ReferencedAssets() const;
+	QStringList MissingAssets() const;
+
+	static QString ErrorPattern();
+
+protected:
+	QRegularExpression mColorCode;
+	QRegularExpression mError;
+	QRegularExpression mWarning;
+	QRegularExpression mFatal;
+	QRegularExpression mAsset;
+	QRegularExpression mMissing;
+	QRegularExpression mProgress;
+	QSet<QString> mReferencedAssets;
+	QSet<QString> mMissingAssets;
+	int mErrorCount;
+	int mWarningCount;
+};
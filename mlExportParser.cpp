@@ -0,0 +1,399 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "stdafx.h"
+
+static const int MaxReportedErrors = 20;
+static const int MaxLineSize = 64 * 1024;
+
+static bool IsKeyword(const char* Begin, const char* End, const char* Keyword)
+{
+	size_t Length = strlen(Keyword);
+	return (size_t)(End - Begin) == Length && !memcmp(Begin, Keyword, Length);
+}
+
+static const char* SkipSpaces(const char* Begin, const char* End)
+{
+	while (Begin < End && (*Begin == ' ' || *Begin == '\t'))
+		Begin++;
+	return Begin;
+}
+
+static const char* TokenEnd(const char* Begin, const char* End)
+{
+	while (Begin < End && *Begin != ' ' && *Begin != '\t')
+		Begin++;
+	return Begin;
+}
+
+// Accepts the numbers the exporters write, '1', '-0.5', '1.5e-07', optionally followed by the ',' separating vector components
+static bool IsNumber(const char* Begin, const char* End)
+{
+	if (Begin < End && End[-1] == ',')
+		End--;
+
+	if (Begin < End && (*Begin == '-' || *Begin == '+'))
+		Begin++;
+
+	const char* Digits = Begin;
+	while (Begin < End && *Begin >= '0' && *Begin <= '9')
+		Begin++;
+
+	bool HasDigits = Begin != Digits;
+
+	if (Begin < End && *Begin == '.')
+	{
+		Begin++;
+		const char* Fraction = Begin;
+		while (Begin < End && *Begin >= '0' && *Begin <= '9')
+			Begin++;
+		HasDigits |= Begin != Fraction;
+	}
+
+	if (!HasDigits)
+		return false;
+
+	if (Begin < End && (*Begin == 'e' || *Begin == 'E'))
+	{
+		Begin++;
+		if (Begin < End && (*Begin == '-' || *Begin == '+'))
+			Begin++;
+
+		const char* Exponent = Begin;
+		while (Begin < End && *Begin >= '0' && *Begin <= '9')
+			Begin++;
+
+		if (Begin == Exponent)
+			return false;
+	}
+
+	return Begin == End;
+}
+
+static int ParseInt(const char* Begin, const char* End)
+{
+	return atoi(QByteArray(Begin, (int)(End - Begin)).constData());
+}
+
+// The quoted name at the end of a BONE or PART definition
+static QByteArray QuotedName(const char* Begin, const char* End)
+{
+	const char* Open = (const char*)memchr(Begin, '"', End - Begin);
+	if (!Open)
+		return QByteArray();
+
+	const char* Close = (const char*)memchr(Open + 1, '"', End - Open - 1);
+	return QByteArray(Open + 1, (int)((Close ? Close : End) - Open - 1));
+}
+
+QString mlExportStats::Summary() const
+{
+	if (Type == ML_EXPORT_MODEL)
+		return QString("%1 bones, %2 verts, %3 tris").arg(Bones).arg(Verts).arg(Tris);
+	if (Type == ML_EXPORT_ANIM)
+		return QString("%1 parts, %2 frames").arg(Parts).arg(Frames);
+	return QString();
+}
+
+mlExportType mlExportParser::TypeFromFileName(const QString& FileName)
+{
+	if (FileName.endsWith(".xmodel_export", Qt::CaseInsensitive))
+		return ML_EXPORT_MODEL;
+	if (FileName.endsWith(".xanim_export", Qt::CaseInsensitive))
+		return ML_EXPORT_ANIM;
+	return ML_EXPORT_UNKNOWN;
+}
+
+mlExportStats mlExportParser::ParseFile(const QString& FileName)
+{
+	mlExportStats Stats;
+
+	QFile File(FileName);
+	if (!File.open(QIODevice::ReadOnly))
+	{
+		Stats.ErrorCount++;
+		Stats.Errors << QString("Could not open '%1'").arg(FileName);
+		return Stats;
+	}
+
+	if (File.size() == 0)
+		return Parse("", 0, TypeFromFileName(FileName));
+
+	uchar* Data = File.map(0, File.size());
+	if (!Data)
+	{
+		Stats.ErrorCount++;
+		Stats.Errors << QString("Could not map '%1'").arg(FileName);
+		return Stats;
+	}
+
+	Stats = Parse((const char*)Data, File.size(), TypeFromFileName(FileName));
+	File.unmap(Data);
+
+	return Stats;
+}
+
+mlExportStats mlExportParser::Parse(const char* Data, qint64 Size, mlExportType ExpectedType)
+{
+	mlExportParser Parser(ExpectedType);
+	Parser.Feed(Data, Size);
+	return Parser.Finish();
+}
+
+mlExportParser::mlExportParser(mlExportType ExpectedType)
+	: mExpectedType(ExpectedType), mDeclaredBones(-1), mDeclaredVerts(-1), mDeclaredTris(-1), mDeclaredParts(-1), mDeclaredFrames(-1), mInFaces(false), mInNotetracks(false), mStopped(false)
+{
+}
+
+void mlExportParser::AddError(qint64 Line, const QString& Error)
+{
+	if (mStats.ErrorCount++ < MaxReportedErrors)
+		mStats.Errors << (Line ? QString("line %1: %2").arg(Line).arg(Error) : Error);
+}
+
+// No valid line comes close to the limit, a longer one means the file is binary or corrupt and would otherwise be buffered whole
+bool mlExportParser::CheckLineSize(qint64 Size)
+{
+	if (Size <= MaxLineSize)
+		return true;
+
+	AddError(mStats.Lines + 1, QString("line is longer than %1 KB").arg(MaxLineSize / 1024));
+	mStopped = true;
+	mPartialLine.clear();
+	return false;
+}
+
+// Data can be split anywhere, only a line that spans two chunks is copied
+void mlExportParser::Feed(const char* Data, qint64 Size)
+{
+	mStats.Size += Size;
+
+	const char* End = Data + Size;
+	const char* Line = Data;
+
+	if (!mPartialLine.isEmpty())
+	{
+		const char* LineEnd = (const char*)memchr(Line, '\n', End - Line);
+		if (!CheckLineSize(mPartialLine.size() + ((LineEnd ? LineEnd : End) - Line)))
+			return;
+
+		if (!LineEnd)
+		{
+			mPartialLine.append(Line, (int)(End - Line));
+			return;
+		}
+
+		mPartialLine.append(Line, (int)(LineEnd - Line));
+		ParseLine(mPartialLine.constData(), mPartialLine.constData() + mPartialLine.size());
+		mPartialLine.clear();
+		Line = LineEnd + 1;
+	}
+
+	while (Line < End && !mStopped)
+	{
+		// memchr is vectorized by the CRT, this is where almost all of the time goes on large files
+		const char* LineEnd = (const char*)memchr(Line, '\n', End - Line);
+		if (!LineEnd)
+		{
+			if (CheckLineSize(End - Line))
+				mPartialLine = QByteArray(Line, (int)(End - Line));
+			return;
+		}
+
+		ParseLine(Line, LineEnd);
+		Line = LineEnd + 1;
+	}
+}
+
+mlExportStats mlExportParser::Finish()
+{
+	if (!mPartialLine.isEmpty())
+	{
+		ParseLine(mPartialLine.constData(), mPartialLine.constData() + mPartialLine.size());
+		mPartialLine.clear();
+	}
+
+	if (mStats.Type == ML_EXPORT_UNKNOWN && !mStats.ErrorCount)
+		AddError(0, "file is empty");
+	else if (mStats.Type != ML_EXPORT_UNKNOWN && mStats.Version <= 0)
+		AddError(0, "missing VERSION");
+
+	auto CheckCount = [&](const char* Name, int Declared, int Found)
+	{
+		if (Declared >= 0 && Declared != Found)
+			AddError(0, QString("%1 is %2 but %3 were found").arg(Name).arg(Declared).arg(Found));
+	};
+
+	CheckCount("NUMBONES", mDeclaredBones, mStats.Bones);
+	CheckCount("NUMVERTS", mDeclaredVerts, mStats.Verts);
+	CheckCount("NUMFACES", mDeclaredTris, mStats.Tris);
+	CheckCount("NUMPARTS", mDeclaredParts, mStats.Parts);
+	CheckCount("NUMFRAMES", mDeclaredFrames, mStats.Frames);
+
+	return mStats;
+}
+
+void mlExportParser::ParseLine(const char* Line, const char* LineEnd)
+{
+	if (mStopped || !CheckLineSize(LineEnd - Line))
+		return;
+
+	mStats.Lines++;
+
+	if (LineEnd > Line && LineEnd[-1] == '\r')
+		LineEnd--;
+
+	const char* Keyword = SkipSpaces(Line, LineEnd);
+
+	if (Keyword == LineEnd || (LineEnd - Keyword >= 2 && Keyword[0] == '/' && Keyword[1] == '/'))
+		return;
+
+	const char* KeywordEnd = TokenEnd(Keyword, LineEnd);
+	const char* Args = SkipSpaces(KeywordEnd, LineEnd);
+
+	if (mStats.Type == ML_EXPORT_UNKNOWN)
+	{
+		if (IsKeyword(Keyword, KeywordEnd, "MODEL"))
+			mStats.Type = ML_EXPORT_MODEL;
+		else if (IsKeyword(Keyword, KeywordEnd, "ANIMATION"))
+			mStats.Type = ML_EXPORT_ANIM;
+		else
+		{
+			AddError(mStats.Lines, "expected MODEL or ANIMATION");
+			mStopped = true;
+			return;
+		}
+
+		if (mExpectedType != ML_EXPORT_UNKNOWN && mStats.Type != mExpectedType)
+			AddError(mStats.Lines, (mExpectedType == ML_EXPORT_MODEL) ? "xmodel_export contains an animation" : "xanim_export contains a model");
+
+		return;
+	}
+
+	switch (*Keyword)
+	{
+	case 'B':
+		if (IsKeyword(Keyword, KeywordEnd, "BONE") && memchr(Args, '"', LineEnd - Args))
+		{
+			mStats.Bones++;
+			QByteArray Name = QuotedName(Args, LineEnd);
+			if (mNames.contains(Name))
+				AddError(mStats.Lines, QString("duplicate bone '%1'").arg(QString::fromLatin1(Name)));
+			mNames.insert(Name);
+		}
+		return;
+
+	case 'F':
+		if (IsKeyword(Keyword, KeywordEnd, "FRAME") && !mInNotetracks)
+		{
+			mStats.Frames++;
+			int FrameIdx = ParseInt(Args, LineEnd);
+			if (mFrameIndices.contains(FrameIdx))
+				AddError(mStats.Lines, QString("duplicate frame %1").arg(FrameIdx));
+			mFrameIndices.insert(FrameIdx);
+			return;
+		}
+		break;
+
+	case 'N':
+		if (IsKeyword(Keyword, KeywordEnd, "NOTETRACKS"))
+		{
+			// Notetrack keys are FRAME lines as well
+			mInNotetracks = true;
+			return;
+		}
+
+		if (KeywordEnd - Keyword > 3 && !memcmp(Keyword, "NUM", 3))
+		{
+			if (!IsNumber(Args, TokenEnd(Args, LineEnd)))
+			{
+				AddError(mStats.Lines, "malformed count");
+				return;
+			}
+
+			int Count = ParseInt(Args, LineEnd);
+			if (IsKeyword(Keyword, KeywordEnd, "NUMBONES"))
+				mDeclaredBones = Count;
+			else if (IsKeyword(Keyword, KeywordEnd, "NUMVERTS") || IsKeyword(Keyword, KeywordEnd, "NUMVERTS32"))
+				mDeclaredVerts = Count;
+			else if (IsKeyword(Keyword, KeywordEnd, "NUMFACES"))
+			{
+				mDeclaredTris = Count;
+				mInFaces = true;
+			}
+			else if (IsKeyword(Keyword, KeywordEnd, "NUMPARTS"))
+				mDeclaredParts = Count;
+			else if (IsKeyword(Keyword, KeywordEnd, "NUMFRAMES"))
+				mDeclaredFrames = Count;
+			return;
+		}
+		break;
+
+	case 'P':
+		if (IsKeyword(Keyword, KeywordEnd, "PART") && memchr(Args, '"', LineEnd - Args))
+		{
+			mStats.Parts++;
+			QByteArray Name = QuotedName(Args, LineEnd);
+			if (mNames.contains(Name))
+				AddError(mStats.Lines, QString("duplicate part '%1'").arg(QString::fromLatin1(Name)));
+			mNames.insert(Name);
+		}
+		return;
+
+	case 'T':
+		if (IsKeyword(Keyword, KeywordEnd, "TRI"))
+		{
+			mStats.Tris++;
+			return;
+		}
+		break;
+
+	case 'V':
+		if (IsKeyword(Keyword, KeywordEnd, "VERSION"))
+		{
+			mStats.Version = ParseInt(Args, LineEnd);
+			return;
+		}
+
+		// Models with more than 65535 verts use VERT32
+		if (IsKeyword(Keyword, KeywordEnd, "VERT") || IsKeyword(Keyword, KeywordEnd, "VERT32"))
+		{
+			if (!mInFaces)
+				mStats.Verts++;
+			return;
+		}
+		break;
+	}
+
+	// Vector data, every argument has to be a number
+	if (IsKeyword(Keyword, KeywordEnd, "OFFSET") || IsKeyword(Keyword, KeywordEnd, "SCALE") || IsKeyword(Keyword, KeywordEnd, "X") || IsKeyword(Keyword, KeywordEnd, "Y") ||
+		IsKeyword(Keyword, KeywordEnd, "Z") || IsKeyword(Keyword, KeywordEnd, "NORMAL") || IsKeyword(Keyword, KeywordEnd, "COLOR") || IsKeyword(Keyword, KeywordEnd, "UV"))
+	{
+		if (Args == LineEnd)
+			AddError(mStats.Lines, QString("%1 has no values").arg(QString::fromLatin1(Keyword, (int)(KeywordEnd - Keyword))));
+
+		for (const char* Token = Args; Token < LineEnd; Token = SkipSpaces(TokenEnd(Token, LineEnd), LineEnd))
+		{
+			if (!IsNumber(Token, TokenEnd(Token, LineEnd)))
+			{
+				AddError(mStats.Lines, QString("malformed number '%1'").arg(QString::fromLatin1(Token, (int)(TokenEnd(Token, LineEnd) - Token))));
+				break;
+			}
+		}
+	}
+}
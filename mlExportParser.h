@@ -0,0 +1,94 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+enum mlExportType
+{
+	ML_EXPORT_UNKNOWN,
+	ML_EXPORT_MODEL,
+	ML_EXPORT_ANIM
+};
+
+struct mlExportStats
+{
+	mlExportStats()
+		: Type(ML_EXPORT_UNKNOWN), Version(0), Size(0), Lines(0), Bones(0), Verts(0), Tris(0), Parts(0), Frames(0), ErrorCount(0)
+	{
+	}
+
+	bool IsValid() const
+	{
+		return ErrorCount == 0;
+	}
+
+	QString Summary() const;
+
+	mlExportType Type;
+	int Version;
+	qint64 Size;
+	qint64 Lines;
+	int Bones;
+	int Verts;
+	int Tris;
+	int Parts;
+	int Frames;
+	int ErrorCount;
+	QStringList Errors;
+};
+
+// Validates xmodel_export and xanim_export files before they are handed to export2bin. Data is fed in chunks of any size
+// as it is read and scanned a line at a time in place, nothing is copied and numbers are only checked, never converted.
+class mlExportParser
+{
+public:
+	mlExportParser(mlExportType ExpectedType);
+
+	void Feed(const char* Data, qint64 Size);
+	mlExportStats Finish();
+
+	// What was found so far, the declared counts are only checked by Finish()
+	const mlExportStats& Stats() const
+	{
+		return mStats;
+	}
+
+	static mlExportStats ParseFile(const QString& FileName);
+	static mlExportStats Parse(const char* Data, qint64 Size, mlExportType ExpectedType);
+
+	static mlExportType TypeFromFileName(const QString& FileName);
+
+protected:
+	void ParseLine(const char* Line, const char* LineEnd);
+	void AddError(qint64 Line, const QString& Error);
+	bool CheckLineSize(qint64 Size);
+
+	mlExportType mExpectedType;
+	mlExportStats mStats;
+	int mDeclaredBones;
+	int mDeclaredVerts;
+	int mDeclaredTris;
+	int mDeclaredParts;
+	int mDeclaredFrames;
+	bool mInFaces;
+	bool mInNotetracks;
+	bool mStopped;
+	QSet<QByteArray> mNames;
+	QSet<int> mFrameIndices;
+	QByteArray mPartialLine;
+};
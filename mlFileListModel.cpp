@@ -0,0 +1,539 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "stdafx.h"
+
+// A filter matches a name if a word of the name starts with it, words are separated by '_', '-' or spaces
+static bool IsWordStart(const QString& Name, int Pos)
+{
+	if (Pos == 0)
+		return true;
+
+	QChar Separator = Name[Pos - 1];
+	return Separator == '_' || Separator == '-' || Separator == ' ';
+}
+
+static bool MatchesWord(const QString& Name, const QString& Filter)
+{
+	for (int Pos = 0; Pos + Filter.length() <= Name.length(); Pos++)
+		if (IsWordStart(Name, Pos) && Name.midRef(Pos, Filter.length()) == Filter)
+			return true;
+
+	return false;
+}
+
+// Used when no word matches, the characters of the filter only have to appear in the name in the same order
+static bool MatchesFuzzy(const QString& Name, const QString& Filter)
+{
+	int Pos = 0;
+	for (int CharIdx = 0; CharIdx < Filter.length(); CharIdx++)
+	{
+		Pos = Name.indexOf(Filter[CharIdx], Pos);
+		if (Pos < 0)
+			return false;
+		Pos++;
+	}
+
+	return true;
+}
+
+mlFileListModel::mlFileListModel(QObject* Parent)
+	: QAbstractItemModel(Parent), mMapsRow(-1), mModsRow(-1), mFuzzyFilter(false), mNameIndexDirty(false)
+{
+	mMapsRow = AddRow(-1, ML_ITEM_UNKNOWN, "Maps", 0);
+	mModsRow = AddRow(-1, ML_ITEM_UNKNOWN, "Mods", 1);
+}
+
+QModelIndex mlFileListModel::index(int Row, int Column, const QModelIndex& Parent) const
+{
+	if (Column != 0 || Row < 0)
+		return QModelIndex();
+
+	if (!Parent.isValid())
+	{
+		if (Row > 1)
+			return QModelIndex();
+		return createIndex(Row, 0, (quintptr)(Row == 0 ? mMapsRow : mModsRow));
+	}
+
+	const QVector<int>& Visible = mRows[(int)Parent.internalId()].Visible;
+	if (Row >= Visible.count())
+		return QModelIndex();
+
+	return createIndex(Row, 0, (quintptr)Visible[Row]);
+}
+
+QModelIndex mlFileListModel::parent(const QModelIndex& Index) const
+{
+	if (!Index.isValid())
+		return QModelIndex();
+
+	int Parent = mRows[(int)Index.internalId()].Parent;
+	if (Parent < 0)
+		return QModelIndex();
+
+	return RowIndex(Parent);
+}
+
+int mlFileListModel::rowCount(const QModelIndex& Parent) const
+{
+	if (!Parent.isValid())
+		return 2;
+
+	if (Parent.column() != 0)
+		return 0;
+
+	return mRows[(int)Parent.internalId()].Visible.count();
+}
+
+int mlFileListModel::columnCount(const QModelIndex& Parent) const
+{
+	return 1;
+}
+
+QVariant mlFileListModel::data(const QModelIndex& Index, int Role) const
+{
+	if (!Index.isValid())
+		return QVariant();
+
+	const mlFileListRow& Row = mRows[(int)Index.internalId()];
+
+	switch (Role)
+	{
+	case Qt::DisplayRole:
+		return Row.Name;
+
+	case Qt::CheckStateRole:
+		if (Row.Type == ML_ITEM_UNKNOWN)
+			return QVariant();
+		return mChecked.contains((int)Index.internalId()) ? Qt::Checked : Qt::Unchecked;
+
+	case Qt::FontRole:
+		if (Row.Parent < 0)
+		{
+			QFont Font;
+			Font.setBold(true);
+			return Font;
+		}
+		return QVariant();
+
+	case Qt::UserRole:
+		return Row.Type;
+	}
+
+	return QVariant();
+}
+
+bool mlFileListModel::setData(const QModelIndex& Index, const QVariant& Value, int Role)
+{
+	if (!Index.isValid() || Role != Qt::CheckStateRole)
+		return false;
+
+	int Id = (int)Index.internalId();
+	if (mRows[Id].Type == ML_ITEM_UNKNOWN)
+		return false;
+
+	if (Value.toInt() == Qt::Checked)
+		mChecked.insert(Id);
+	else
+		mChecked.remove(Id);
+
+	emit dataChanged(Index, Index);
+	return true;
+}
+
+Qt::ItemFlags mlFileListModel::flags(const QModelIndex& Index) const
+{
+	if (!Index.isValid())
+		return Qt::NoItemFlags;
+
+	Qt::ItemFlags Flags = Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+	if (mRows[(int)Index.internalId()].Type != ML_ITEM_UNKNOWN)
+		Flags |= Qt::ItemIsUserCheckable;
+
+	return Flags;
+}
+
+QString mlFileListModel::MapKey(const QString& Name)
+{
+	return "map/" + Name;
+}
+
+QString mlFileListModel::ModKey(const QString& Name)
+{
+	return "mod/" + Name;
+}
+
+QString mlFileListModel::ZoneKey(const QString& ModName, const QString& Zone)
+{
+	return "mod/" + ModName + "/" + Zone;
+}
+
+bool mlFileListModel::Contains(const QString& Key) const
+{
+	return mKeys.contains(Key);
+}
+
+QStringList mlFileListModel::Keys() const
+{
+	return mKeys.keys();
+}
+
+QString mlFileListModel::Key(const QModelIndex& Index) const
+{
+	if (!Index.isValid())
+		return QString();
+
+	return RowKey((int)Index.internalId());
+}
+
+QModelIndex mlFileListModel::IndexOf(const QString& Key) const
+{
+	int Id = mKeys.value(Key, -1);
+	if (Id < 0 || !IsLive(Id))
+		return QModelIndex();
+
+	return RowIndex(Id);
+}
+
+void mlFileListModel::AddMap(const QString& Name)
+{
+	if (mKeys.contains(MapKey(Name)))
+		return;
+
+	UpdateRow(AddRow(mMapsRow, ML_ITEM_MAP, Name, 0));
+}
+
+// The zones of a new mod are added before the mod is shown, so the view gets a single insert for all of them
+void mlFileListModel::AddMod(const QString& Name, const QStringList& Zones)
+{
+	int ModId = mKeys.value(ModKey(Name), -1);
+	if (ModId < 0)
+		ModId = AddRow(mModsRow, ML_ITEM_UNKNOWN, Name, 0);
+
+	for (int ZoneIdx = 0; ZoneIdx < Zones.count(); ZoneIdx++)
+		if (!mKeys.contains(ZoneKey(Name, Zones[ZoneIdx])))
+			UpdateRow(AddRow(ModId, ML_ITEM_MOD, Zones[ZoneIdx], ZoneIdx));
+
+	UpdateRow(ModId);
+}
+
+void mlFileListModel::Remove(const QString& Key)
+{
+	int Id = mKeys.value(Key, -1);
+	if (Id < 0)
+		return;
+
+	HideRow(Id);
+
+	int Parent = mRows[Id].Parent;
+	QVector<int>& Children = mRows[Parent].Children;
+	Children.remove(LowerBound(Children, Id));
+
+	FreeRow(Id);
+}
+
+mlBuildItem mlFileListModel::Item(const QModelIndex& Index) const
+{
+	if (!Index.isValid())
+		return mlBuildItem();
+
+	return RowItem((int)Index.internalId());
+}
+
+// Checked items are returned in list order, maps first
+QList<mlBuildItem> mlFileListModel::CheckedItems() const
+{
+	QList<int> Ids = mChecked.toList();
+	std::sort(Ids.begin(), Ids.end(), [this](int Left, int Right)
+	{
+		int LeftOuter = (mRows[Left].Type == ML_ITEM_MOD) ? mRows[Left].Parent : Left;
+		int RightOuter = (mRows[Right].Type == ML_ITEM_MOD) ? mRows[Right].Parent : Right;
+
+		if (LeftOuter == RightOuter)
+			return LessThan(Left, Right);
+		if (mRows[LeftOuter].Parent != mRows[RightOuter].Parent)
+			return mRows[LeftOuter].Parent == mMapsRow;
+		return LessThan(LeftOuter, RightOuter);
+	});
+
+	QList<mlBuildItem> Items;
+	for (int Id : Ids)
+		Items.append(RowItem(Id));
+
+	return Items;
+}
+
+// Typing more characters only narrows a fuzzy filter, so only the previous matches have to be checked again. A word
+// filter is always answered from the name index.
+void mlFileListModel::SetFilter(const QString& Filter)
+{
+	QString Folded = Filter.trimmed().toLower();
+	if (Folded == mFilter)
+		return;
+
+	QSet<int> Matches;
+	bool FuzzyFilter = false;
+
+	if (!Folded.isEmpty())
+	{
+		if (mNameIndexDirty)
+			BuildNameIndex();
+
+		auto Entry = std::lower_bound(mNameIndex.constBegin(), mNameIndex.constEnd(), Folded, [](const QPair<QString, int>& Left, const QString& Right)
+		{
+			return Left.first < Right;
+		});
+
+		for (; Entry != mNameIndex.constEnd() && Entry->first.startsWith(Folded); ++Entry)
+			Matches.insert(Entry->second);
+
+		if (Matches.isEmpty())
+		{
+			FuzzyFilter = true;
+
+			if (mFuzzyFilter && Folded.startsWith(mFilter))
+			{
+				for (int Id : mMatches)
+					if (MatchesFuzzy(mRows[Id].Folded, Folded))
+						Matches.insert(Id);
+			}
+			else
+			{
+				for (int Id = 0; Id < mRows.count(); Id++)
+				{
+					const mlFileListRow& Row = mRows[Id];
+					if ((Row.Parent == mMapsRow || Row.Parent == mModsRow) && MatchesFuzzy(Row.Folded, Folded))
+						Matches.insert(Id);
+				}
+			}
+		}
+	}
+
+	mFilter = Folded;
+	mFuzzyFilter = FuzzyFilter;
+	mMatches = Matches;
+
+	// Only the rows that appear or disappear are reported to the view, the others keep their state in it
+	for (int HeaderId : QList<int>() << mMapsRow << mModsRow)
+		for (int Id : mRows[HeaderId].Children)
+			UpdateRow(Id);
+}
+
+int mlFileListModel::AddRow(int Parent, mlItemType Type, const QString& Name, int Position)
+{
+	int Id;
+	if (mFreeRows.isEmpty())
+	{
+		Id = mRows.count();
+		mRows.append(mlFileListRow());
+	}
+	else
+		Id = mFreeRows.takeLast();
+
+	mlFileListRow& Row = mRows[Id];
+	Row.Type = Type;
+	Row.Name = Name;
+	Row.Folded = Name.toLower();
+	Row.Parent = Parent;
+	Row.Position = Position;
+
+	if (Parent < 0)
+	{
+		Row.Shown = true;
+		return Id;
+	}
+
+	QVector<int>& Children = mRows[Parent].Children;
+	Children.insert(LowerBound(Children, Id), Id);
+	mKeys.insert(RowKey(Id), Id);
+
+	if (Parent == mMapsRow || Parent == mModsRow)
+	{
+		mNameIndexDirty = true;
+
+		if (!mFilter.isEmpty() && (mFuzzyFilter ? MatchesFuzzy(Row.Folded, mFilter) : MatchesWord(Row.Folded, mFilter)))
+			mMatches.insert(Id);
+	}
+
+	return Id;
+}
+
+// The row has to be hidden already, its children are not part of the view anymore and are freed with it
+void mlFileListModel::FreeRow(int Id)
+{
+	for (int ChildId : mRows[Id].Children)
+		FreeRow(ChildId);
+
+	mKeys.remove(RowKey(Id));
+	mChecked.remove(Id);
+	mMatches.remove(Id);
+	if (mRows[Id].Parent == mMapsRow || mRows[Id].Parent == mModsRow)
+		mNameIndexDirty = true;
+
+	mRows[Id] = mlFileListRow();
+	mFreeRows.append(Id);
+}
+
+QString mlFileListModel::RowKey(int Id) const
+{
+	const mlFileListRow& Row = mRows[Id];
+
+	if (Row.Type == ML_ITEM_MAP)
+		return MapKey(Row.Name);
+	if (Row.Type == ML_ITEM_MOD)
+		return ZoneKey(mRows[Row.Parent].Name, Row.Name);
+	if (Row.Parent == mModsRow)
+		return ModKey(Row.Name);
+
+	return QString();
+}
+
+// Mod folders are returned as an unknown item with the mod name, the headings as an empty item
+mlBuildItem mlFileListModel::RowItem(int Id) const
+{
+	const mlFileListRow& Row = mRows[Id];
+
+	if (Row.Type == ML_ITEM_MAP)
+		return mlBuildItem(ML_ITEM_MAP, Row.Name);
+	if (Row.Type == ML_ITEM_MOD)
+		return mlBuildItem(ML_ITEM_MOD, mRows[Row.Parent].Name, Row.Name);
+	if (Row.Parent == mModsRow)
+		return mlBuildItem(ML_ITEM_UNKNOWN, Row.Name);
+
+	return mlBuildItem();
+}
+
+// Maps and mods are sorted by name, zones keep the order they were found in
+bool mlFileListModel::LessThan(int Left, int Right) const
+{
+	const mlFileListRow& LeftRow = mRows[Left];
+	const mlFileListRow& RightRow = mRows[Right];
+
+	if (LeftRow.Position != RightRow.Position)
+		return LeftRow.Position < RightRow.Position;
+
+	int Compare = LeftRow.Folded.compare(RightRow.Folded);
+	if (Compare != 0)
+		return Compare < 0;
+
+	return LeftRow.Name < RightRow.Name;
+}
+
+int mlFileListModel::LowerBound(const QVector<int>& Rows, int Id) const
+{
+	return std::lower_bound(Rows.begin(), Rows.end(), Id, [this](int Left, int Right)
+	{
+		return LessThan(Left, Right);
+	}) - Rows.begin();
+}
+
+bool mlFileListModel::IsLive(int Id) const
+{
+	const mlFileListRow& Row = mRows[Id];
+	return Row.Parent < 0 || (Row.Shown && IsLive(Row.Parent));
+}
+
+int mlFileListModel::VisibleRow(int Id) const
+{
+	int Parent = mRows[Id].Parent;
+	if (Parent < 0)
+		return (Id == mMapsRow) ? 0 : 1;
+
+	return LowerBound(mRows[Parent].Visible, Id);
+}
+
+QModelIndex mlFileListModel::RowIndex(int Id) const
+{
+	return createIndex(VisibleRow(Id), 0, (quintptr)Id);
+}
+
+bool mlFileListModel::MatchesFilter(int Id) const
+{
+	if (mFilter.isEmpty() || mRows[Id].Type == ML_ITEM_MOD)
+		return true;
+
+	return mMatches.contains(Id);
+}
+
+void mlFileListModel::UpdateRow(int Id)
+{
+	if (MatchesFilter(Id))
+		ShowRow(Id);
+	else
+		HideRow(Id);
+}
+
+// Rows below a hidden row are not part of the view, they are added and removed without notifying it
+void mlFileListModel::ShowRow(int Id)
+{
+	if (mRows[Id].Shown)
+		return;
+
+	int Parent = mRows[Id].Parent;
+	bool Live = IsLive(Parent);
+	int Row = VisibleRow(Id);
+
+	if (Live)
+		beginInsertRows(RowIndex(Parent), Row, Row);
+
+	mRows[Parent].Visible.insert(Row, Id);
+	mRows[Id].Shown = true;
+
+	if (Live)
+		endInsertRows();
+}
+
+void mlFileListModel::HideRow(int Id)
+{
+	if (!mRows[Id].Shown)
+		return;
+
+	int Parent = mRows[Id].Parent;
+	bool Live = IsLive(Parent);
+	int Row = VisibleRow(Id);
+
+	if (Live)
+		beginRemoveRows(RowIndex(Parent), Row, Row);
+
+	mRows[Parent].Visible.remove(Row);
+	mRows[Id].Shown = false;
+
+	if (Live)
+		endRemoveRows();
+}
+
+// Every word of a map or mod name is an entry, so "fac" finds zm_factory
+void mlFileListModel::BuildNameIndex()
+{
+	mNameIndex.clear();
+
+	for (int HeaderId : QList<int>() << mMapsRow << mModsRow)
+	{
+		for (int Id : mRows[HeaderId].Children)
+		{
+			const QString& Folded = mRows[Id].Folded;
+			for (int Pos = 0; Pos < Folded.length(); Pos++)
+				if (IsWordStart(Folded, Pos))
+					mNameIndex.append(qMakePair(Folded.mid(Pos), Id));
+		}
+	}
+
+	std::sort(mNameIndex.begin(), mNameIndex.end());
+	mNameIndexDirty = false;
+}
@@ -0,0 +1,106 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+// One row of the map list: the Maps or Mods heading, a map, a mod folder or a zone of a mod
+struct mlFileListRow
+{
+	mlFileListRow()
+		: Type(ML_ITEM_UNKNOWN), Parent(-1), Position(0), Shown(false)
+	{
+	}
+
+	mlItemType Type;
+	QString Name;
+	QString Folded;
+	int Parent;
+	int Position;
+	bool Shown;
+	QVector<int> Children;
+	QVector<int> Visible;
+};
+
+// The map list keeps all of its rows in one flat array, the row id is the internal id of a model index. Checked rows
+// are kept in a set so collecting them does not walk the tree, and the filter is looked up in a sorted index of the
+// words in the map and mod names. Zones are shown whenever their mod is.
+class mlFileListModel : public QAbstractItemModel
+{
+public:
+	mlFileListModel(QObject* Parent = NULL);
+
+	QModelIndex index(int Row, int Column, const QModelIndex& Parent = QModelIndex()) const;
+	QModelIndex parent(const QModelIndex& Index) const;
+	int rowCount(const QModelIndex& Parent = QModelIndex()) const;
+	int columnCount(const QModelIndex& Parent = QModelIndex()) const;
+	QVariant data(const QModelIndex& Index, int Role = Qt::DisplayRole) const;
+	bool setData(const QModelIndex& Index, const QVariant& Value, int Role = Qt::EditRole);
+	Qt::ItemFlags flags(const QModelIndex& Index) const;
+
+	static QString MapKey(const QString& Name);
+	static QString ModKey(const QString& Name);
+	static QString ZoneKey(const QString& ModName, const QString& Zone);
+
+	bool Contains(const QString& Key) const;
+	QStringList Keys() const;
+	QString Key(const QModelIndex& Index) const;
+	QModelIndex IndexOf(const QString& Key) const;
+
+	void AddMap(const QString& Name);
+	void AddMod(const QString& Name, const QStringList& Zones);
+	void Remove(const QString& Key);
+
+	mlBuildItem Item(const QModelIndex& Index) const;
+	QList<mlBuildItem> CheckedItems() const;
+
+	QString Filter() const
+	{
+		return mFilter;
+	}
+
+	void SetFilter(const QString& Filter);
+
+protected:
+	int AddRow(int Parent, mlItemType Type, const QString& Name, int Position);
+	void FreeRow(int Id);
+	QString RowKey(int Id) const;
+	mlBuildItem RowItem(int Id) const;
+	bool LessThan(int Left, int Right) const;
+	int LowerBound(const QVector<int>& Rows, int Id) const;
+	bool IsLive(int Id) const;
+	int VisibleRow(int Id) const;
+	QModelIndex RowIndex(int Id) const;
+	bool MatchesFilter(int Id) const;
+	void UpdateRow(int Id);
+	void ShowRow(int Id);
+	void HideRow(int Id);
+	void BuildNameIndex();
+
+	QVector<mlFileListRow> mRows;
+	QVector<int> mFreeRows;
+	int mMapsRow;
+	int mModsRow;
+	QHash<QString, int> mKeys;
+	QSet<int> mChecked;
+
+	QString mFilter;
+	bool mFuzzyFilter;
+	QSet<int> mMatches;
+	QVector<QPair<QString, int>> mNameIndex;
+	bool mNameIndexDirty;
+};
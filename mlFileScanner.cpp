@@ -0,0 +1,174 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "stdafx.h"
+
+QString mlFileScanner::RootFolder(const QString& GamePath, mlItemType Type)
+{
+	return QDir::cleanPath(QString((Type == ML_ITEM_MAP) ? "%1/usermaps/" : "%1/mods/").arg(GamePath));
+}
+
+qint64 mlFileScanner::ModifiedTime(const QString& Path)
+{
+	QFileInfo FileInfo(Path);
+	return FileInfo.exists() ? FileInfo.lastModified().toMSecsSinceEpoch() : -1;
+}
+
+// A map has a single zone named after its folder, a mod has one zone per game mode. The zone files are only checked
+// when the zone_source folder changed since the known entry was scanned.
+mlFileScanEntry mlFileScanner::ScanFolder(const QString& GamePath, mlItemType Type, const QString& Name, const mlFileScanEntry* Known)
+{
+	QString ZoneFolder = QString("%1/%2/zone_source/").arg(RootFolder(GamePath, Type), Name);
+	qint64 Modified = ModifiedTime(ZoneFolder);
+
+	if (Known && Known->Modified == Modified && Modified != -1)
+		return *Known;
+
+	mlFileScanEntry Entry;
+	Entry.Type = Type;
+	Entry.Name = Name;
+	Entry.Modified = Modified;
+
+	if (Type == ML_ITEM_MAP)
+	{
+		if (QFileInfo(ZoneFolder + Name + ".zone").isFile())
+			Entry.Zones << Name;
+	}
+	else
+	{
+		for (const char* ModZone : gModZones)
+			if (QFileInfo(ZoneFolder + ModZone + ".zone").isFile())
+				Entry.Zones << ModZone;
+	}
+
+	return Entry;
+}
+
+mlFileIndex::mlFileIndex(const QString& FileName, const QString& GamePath)
+	: mFileName(FileName), mGamePath(QDir::cleanPath(GamePath))
+{
+	mRootModified[0] = -1;
+	mRootModified[1] = -1;
+}
+
+QString mlFileIndex::DefaultFileName(const QString& ToolsPath)
+{
+	return QString("%1/share/modlauncher/file_index.dat").arg(ToolsPath);
+}
+
+// Binary rather than JSON, this is read before the window shows up and has to stay fast with thousands of entries
+static const quint32 FileIndexMagic = 0x49464C4D;
+static const qint32 FileIndexVersion = 1;
+
+bool mlFileIndex::Load()
+{
+	QFile File(mFileName);
+	if (!File.open(QIODevice::ReadOnly))
+		return false;
+
+	QDataStream Stream(&File);
+	Stream.setVersion(QDataStream::Qt_5_0);
+
+	quint32 Magic;
+	qint32 Version;
+	QString GamePath;
+	Stream >> Magic >> Version >> GamePath;
+
+	// An index written for another game folder is no use, the scan starts from scratch
+	if (Magic != FileIndexMagic || Version != FileIndexVersion || GamePath.compare(mGamePath, Qt::CaseInsensitive))
+		return false;
+
+	for (int TypeIdx = 0; TypeIdx < 2; TypeIdx++)
+	{
+		qint32 Count;
+		Stream >> mRootModified[TypeIdx] >> Count;
+
+		for (int EntryIdx = 0; EntryIdx < Count && Stream.status() == QDataStream::Ok; EntryIdx++)
+		{
+			mlFileScanEntry Entry;
+			Entry.Type = TypeIdx ? ML_ITEM_MOD : ML_ITEM_MAP;
+			Stream >> Entry.Name >> Entry.Zones >> Entry.Modified;
+			mEntries[TypeIdx].insert(Entry.Name, Entry);
+		}
+	}
+
+	if (Stream.status() != QDataStream::Ok)
+	{
+		mRootModified[0] = mRootModified[1] = -1;
+		mEntries[0].clear();
+		mEntries[1].clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool mlFileIndex::Save() const
+{
+	QDir().mkpath(QFileInfo(mFileName).absolutePath());
+
+	QSaveFile File(mFileName);
+	if (!File.open(QIODevice::WriteOnly))
+		return false;
+
+	QDataStream Stream(&File);
+	Stream.setVersion(QDataStream::Qt_5_0);
+	Stream << FileIndexMagic << FileIndexVersion << mGamePath;
+
+	for (int TypeIdx = 0; TypeIdx < 2; TypeIdx++)
+	{
+		Stream << mRootModified[TypeIdx] << (qint32)mEntries[TypeIdx].count();
+
+		for (const mlFileScanEntry& Entry : mEntries[TypeIdx])
+			Stream << Entry.Name << Entry.Zones << Entry.Modified;
+	}
+
+	return File.commit();
+}
+
+qint64 mlFileIndex::RootModified(mlItemType Type) const
+{
+	return mRootModified[Type == ML_ITEM_MOD];
+}
+
+QStringList mlFileIndex::Names(mlItemType Type) const
+{
+	return mEntries[Type == ML_ITEM_MOD].keys();
+}
+
+const mlFileScanEntry* mlFileIndex::Find(mlItemType Type, const QString& Name) const
+{
+	QMap<QString, mlFileScanEntry>::const_iterator It = mEntries[Type == ML_ITEM_MOD].constFind(Name);
+	return (It != mEntries[Type == ML_ITEM_MOD].constEnd()) ? &It.value() : NULL;
+}
+
+QList<mlFileScanEntry> mlFileIndex::Entries() const
+{
+	return mEntries[0].values() + mEntries[1].values();
+}
+
+void mlFileIndex::SetRoot(mlItemType Type, qint64 Modified, const QList<mlFileScanEntry>& Entries)
+{
+	int TypeIdx = (Type == ML_ITEM_MOD);
+
+	mRootModified[TypeIdx] = Modified;
+	mEntries[TypeIdx].clear();
+
+	for (const mlFileScanEntry& Entry : Entries)
+		mEntries[TypeIdx].insert(Entry.Name, Entry);
+}
@@ -0,0 +1,91 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+// A map or mod folder with the zones that can be built from it
+struct mlFileScanEntry
+{
+	mlFileScanEntry()
+		: Type(ML_ITEM_UNKNOWN), Modified(-1)
+	{
+	}
+
+	bool IsValid() const
+	{
+		return !Zones.isEmpty();
+	}
+
+	mlItemType Type;
+	QString Name;
+	QStringList Zones;
+	qint64 Modified;
+};
+
+class mlFileScanner
+{
+public:
+	static QString RootFolder(const QString& GamePath, mlItemType Type);
+	static qint64 ModifiedTime(const QString& Path);
+	static mlFileScanEntry ScanFolder(const QString& GamePath, mlItemType Type, const QString& Name, const mlFileScanEntry* Known = NULL);
+};
+
+// Every map and mod folder found by the last scan, including the ones without zones. Adding or removing a zone file
+// changes the modification time of its zone_source folder, and adding or removing a folder changes the time of
+// usermaps/ or mods/, so a scan only has to look into the folders whose time changed.
+class mlFileIndex
+{
+public:
+	mlFileIndex(const QString& FileName, const QString& GamePath);
+
+	static QString DefaultFileName(const QString& ToolsPath);
+
+	bool Load();
+	bool Save() const;
+
+	qint64 RootModified(mlItemType Type) const;
+	QStringList Names(mlItemType Type) const;
+	const mlFileScanEntry* Find(mlItemType Type, const QString& Name) const;
+	QList<mlFileScanEntry> Entries() const;
+
+	void SetRoot(mlItemType Type, qint64 Modified, const QList<mlFileScanEntry>& Entries);
+
+protected:
+	QString mFileName;
+	QString mGamePath;
+	qint64 mRootModified[2];
+	QMap<QString, mlFileScanEntry> mEntries[2];
+};
+
+// Runs a function on a QThreadPool
+class mlFunctionTask : public QRunnable
+{
+public:
+	mlFunctionTask(const std::function<void ()>& Function)
+		: mFunction(Function)
+	{
+	}
+
+	void run()
+	{
+		mFunction();
+	}
+
+protected:
+	std::function<void ()> mFunction;
+};
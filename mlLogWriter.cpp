@@ -0,0 +1,185 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "stdafx.h"
+
+// Output is written in batches of this size, or after a short delay when less is waiting
+static const int FlushSize = 64 * 1024;
+static const int FlushDelayMs = 250;
+
+mlLogWriter::mlLogWriter()
+	: mFlush(false), mStop(false)
+{
+}
+
+mlLogWriter::~mlLogWriter()
+{
+	Close();
+}
+
+bool mlLogWriter::Open(const QString& FileName)
+{
+	Close();
+
+	QDir().mkpath(QFileInfo(FileName).absolutePath());
+
+	mFile.setFileName(FileName);
+	if (!mFile.open(QIODevice::WriteOnly))
+		return false;
+
+	mStop = false;
+	start(QThread::LowPriority);
+	return true;
+}
+
+// Each call is one paragraph, the same as QPlainTextEdit::appendPlainText()
+void mlLogWriter::Write(const QString& Output)
+{
+	QMutexLocker Locker(&mMutex);
+
+	if (!mFile.isOpen())
+		return;
+
+	mBuffer.append(Output.toUtf8());
+	mBuffer.append('\n');
+
+	if (mBuffer.size() >= FlushSize)
+		mCondition.wakeOne();
+}
+
+// Waits until everything written so far is in the file, e.g. before the file is copied
+void mlLogWriter::Flush()
+{
+	QMutexLocker Locker(&mMutex);
+
+	if (!mFile.isOpen())
+		return;
+
+	mFlush = true;
+	mCondition.wakeOne();
+
+	while (mFlush)
+		mFlushed.wait(&mMutex);
+}
+
+void mlLogWriter::Close()
+{
+	if (!mFile.isOpen())
+		return;
+
+	mMutex.lock();
+	mStop = true;
+	mCondition.wakeOne();
+	mMutex.unlock();
+
+	wait();
+	mFile.close();
+}
+
+void mlLogWriter::run()
+{
+	QMutexLocker Locker(&mMutex);
+
+	for (;;)
+	{
+		while (!mStop && !mFlush && mBuffer.size() < FlushSize)
+			if (!mCondition.wait(&mMutex, FlushDelayMs))
+				break;
+
+		QByteArray Data;
+		Data.swap(mBuffer);
+		bool Stop = mStop;
+		bool Flush = mFlush;
+
+		Locker.unlock();
+
+		if (!Data.isEmpty())
+		{
+			mFile.write(Data);
+			mFile.flush();
+		}
+
+		Locker.relock();
+
+		if (Flush)
+		{
+			mFlush = false;
+			mFlushed.wakeAll();
+		}
+
+		if (Stop)
+			break;
+	}
+}
+
+mlOutputQueue::mlOutputQueue(int FrameSize, int MaxSize)
+	: mFrameSize(FrameSize), mMaxSize(MaxSize), mSize(0), mSkippedLines(0), mTotalSkippedLines(0), mMaxLatency(0)
+{
+	mTimer.start();
+}
+
+// Each chunk is one paragraph, the same as QPlainTextEdit::appendPlainText()
+void mlOutputQueue::Append(const QString& Output)
+{
+	mlOutputChunk Chunk;
+	Chunk.Text = Output;
+	Chunk.Queued = mTimer.elapsed();
+	mChunks.append(Chunk);
+	mSize += Output.size();
+
+	while (mSize > mMaxSize && mChunks.count() > 1)
+	{
+		const QString& Dropped = mChunks.first().Text;
+		mSkippedLines += Dropped.count('\n') + 1;
+		mSize -= Dropped.size();
+		mChunks.removeFirst();
+	}
+}
+
+QString mlOutputQueue::TakeFrame()
+{
+	QStringList Texts;
+	int FrameSize = 0;
+
+	if (mSkippedLines > 0)
+	{
+		Texts.append(QString("... %1 lines skipped, the session log has the full output ...").arg(mSkippedLines));
+		mTotalSkippedLines += mSkippedLines;
+		mSkippedLines = 0;
+	}
+
+	if (!mChunks.isEmpty())
+		mMaxLatency = qMax(mMaxLatency, mTimer.elapsed() - mChunks.first().Queued);
+
+	while (!mChunks.isEmpty() && (FrameSize == 0 || FrameSize + mChunks.first().Text.size() <= mFrameSize))
+	{
+		FrameSize += mChunks.first().Text.size();
+		Texts.append(mChunks.takeFirst().Text);
+	}
+
+	mSize -= FrameSize;
+	return Texts.join('\n');
+}
+
+void mlOutputQueue::Clear()
+{
+	mChunks.clear();
+	mSize = 0;
+	mSkippedLines = 0;
+	mMaxLatency = 0;
+}
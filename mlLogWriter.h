@@ -0,0 +1,92 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+// Writes a session's output to disk from a background thread, so the log is kept in full no matter how much output the window holds
+class mlLogWriter : public QThread
+{
+public:
+	mlLogWriter();
+	~mlLogWriter();
+
+	bool Open(const QString& FileName);
+	void Write(const QString& Output);
+	void Flush();
+	void Close();
+
+	QString FileName() const
+	{
+		return mFile.fileName();
+	}
+
+protected:
+	void run();
+
+	QFile mFile;
+	QMutex mMutex;
+	QWaitCondition mCondition;
+	QWaitCondition mFlushed;
+	QByteArray mBuffer;
+	bool mFlush;
+	bool mStop;
+};
+
+// Output waiting to be appended to the output window, a bounded amount at a time. When output arrives faster than it can
+// be shown, the oldest waiting output is dropped and a marker says how many lines are only in the session log.
+class mlOutputQueue
+{
+public:
+	mlOutputQueue(int FrameSize = 256 * 1024, int MaxSize = 4 * 1024 * 1024);
+
+	void Append(const QString& Output);
+	QString TakeFrame();
+	void Clear();
+
+	bool IsEmpty() const
+	{
+		return mChunks.isEmpty() && mSkippedLines == 0;
+	}
+
+	// The longest any output waited to be taken since the queue was cleared, in milliseconds
+	qint64 MaxLatency() const
+	{
+		return mMaxLatency;
+	}
+
+	qint64 SkippedLines() const
+	{
+		return mTotalSkippedLines;
+	}
+
+protected:
+	struct mlOutputChunk
+	{
+		QString Text;
+		qint64 Queued;
+	};
+
+	QList<mlOutputChunk> mChunks;
+	QElapsedTimer mTimer;
+	int mFrameSize;
+	int mMaxSize;
+	int mSize;
+	qint64 mSkippedLines;
+	qint64 mTotalSkippedLines;
+	qint64 mMaxLatency;
+};
@@ -29,7 +29,6 @@
 
 const int AppId = 311210;
 
-const char* gLanguages[] = { "english", "french", "italian", "spanish", "german", "portuguese", "russian", "polish", "japanese", "traditionalchinese", "simplifiedchinese", "englisharabic" };
 const char* gTags[] = { "Animation", "Audio", "Character", "Map", "Mod", "Mode", "Model", "Multiplayer", "Scorestreak", "Skin", "Specialist", "Texture", "UI", "Vehicle", "Visual Effect", "Weapon", "WIP", "Zombies" };
 dvar_s gDvars[] = {
 					{"ai_disableSpawn", "Disable AI from spawning", DVAR_VALUE_BOOL},
@@ -42,203 +41,120 @@ dvar_s gDvars[] = {
 					{"splitscreen", "Enable splitscreen", DVAR_VALUE_BOOL},
 					{"splitscreen_playerCount", "Allocate the number of instances for splitscreen", DVAR_VALUE_INT, 0, 2}
 				 };
-enum mlItemType
-{
-	ML_ITEM_UNKNOWN,
-	ML_ITEM_MAP,
-	ML_ITEM_MOD
-};
 
-mlBuildThread::mlBuildThread(const QList<QPair<QString, QStringList>>& Commands, bool IgnoreErrors)
-	: mCommands(Commands), mSuccess(false), mCancel(false), mIgnoreErrors(IgnoreErrors)
+mlFileScanThread::mlFileScanThread(const QString& GamePath, const QString& IndexFileName)
+	: mGamePath(GamePath), mIndexFileName(IndexFileName), mCancel(false)
 {
 }
 
-void mlBuildThread::run()
+// Network drives answer each stat slowly but handle many at once, so every folder is checked on its own pool thread.
+// Results are still reported in name order, as soon as every folder before them has been checked.
+void mlFileScanThread::run()
 {
-	bool Success = true;
-
-	for (const QPair<QString, QStringList>& Command : mCommands)
+	struct mlScanFolder
 	{
-		QProcess* Process = new QProcess();
-		connect(Process, SIGNAL(finished(int)), Process, SLOT(deleteLater()));
-		Process->setWorkingDirectory(QFileInfo(Command.first).absolutePath());
-		Process->setProcessChannelMode(QProcess::MergedChannels);
-
-		emit OutputReady(Command.first + ' ' + Command.second.join(' ') + "\n");
-
-		Process->start(Command.first, Command.second);
-		for (;;)
-		{
-			Sleep(100);
-
-			if (Process->waitForReadyRead(0))
-				emit OutputReady(Process->readAll());
-
-			QProcess::ProcessState State = Process->state();
-			if (State == QProcess::NotRunning)
-				break;
-
-			if (mCancel)
-				Process->kill();
-		}
-
-		if (Process->exitStatus() != QProcess::NormalExit)
-			return;
-
-		if (Process->exitCode() != 0)
-		{
-			Success = false;
-			if (!mIgnoreErrors)
-				return;
-		}
-	}
-
-	mSuccess = Success;
-}
-
-mlConvertThread::mlConvertThread(QStringList& Files, QString& OutputDir, bool IgnoreErrors, bool OverwriteFiles)
-	: mFiles(Files), mOutputDir(OutputDir), mSuccess(false), mCancel(false), mIgnoreErrors(IgnoreErrors), mOverwrite(OverwriteFiles)
-{
-}
+		mlItemType Type;
+		QString Name;
+	};
 
-void mlConvertThread::run()
-{
-	bool Success = true;
+	mlFileIndex Index(mIndexFileName, mGamePath);
+	Index.Load();
 
-	unsigned int convCountSuccess	= 0;
-	unsigned int convCountSkipped	= 0;
-	unsigned int convCountFailed	= 0;
+	QVector<mlScanFolder> Folders;
+	mlItemType Types[] = { ML_ITEM_MAP, ML_ITEM_MOD };
+	qint64 RootModified[2];
 
-	for (QString file : mFiles)
+	for (int TypeIdx = 0; TypeIdx < 2; TypeIdx++)
 	{
-		QFileInfo file_info(file);
-		QString working_directory = file_info.absolutePath();
-
-		QProcess* Process = new QProcess();
-		connect(Process, SIGNAL(finished(int)), Process, SLOT(deleteLater()));
-		Process->setWorkingDirectory(working_directory);
-		Process->setProcessChannelMode(QProcess::MergedChannels);
-
-		file = file_info.baseName();
-
-		QString ToolsPath = QDir::fromNativeSeparators(getenv("TA_TOOLS_PATH"));
-		QString ExecutablePath = QString("%1bin/export2bin.exe").arg(ToolsPath);
-
-		QStringList args;
-		//args.append("/v"); // Verbose
-		args.append("/piped");
-
-		QString filepath = file_info.absoluteFilePath();
-
-		QString ext = file_info.suffix().toUpper();
-		if (ext == "XANIM_EXPORT")
-			ext = ".XANIM_BIN";
-		else if (ext == "XMODEL_EXPORT")
-			ext = ".XMODEL_BIN";
+		mlItemType Type = Types[TypeIdx];
+		QString RootFolder = mlFileScanner::RootFolder(mGamePath, Type);
+
+		// The folder list only has to be read again when a folder was added, removed or renamed
+		RootModified[TypeIdx] = mlFileScanner::ModifiedTime(RootFolder);
+		QStringList Names;
+		if (RootModified[TypeIdx] != -1 && RootModified[TypeIdx] == Index.RootModified(Type))
+			Names = Index.Names(Type);
 		else
-		{
-			emit OutputReady("Export2Bin: Skipping file '" + filepath + "' (file has invalid extension)\n");
-			convCountSkipped++;
-			continue;
-		}
+			Names = QDir(RootFolder).entryList(QDir::AllDirs | QDir::NoDotAndDotDot);
 
-		QString target_filepath = QDir::cleanPath(mOutputDir) + QDir::separator() + file + ext;
-
-		QFile infile(filepath);
-		QFile outfile(target_filepath);
-
-		if (!mOverwrite && outfile.exists())
+		std::sort(Names.begin(), Names.end(), [](const QString& A, const QString& B)
 		{
-			emit OutputReady("Export2Bin: Skipping file '" + filepath + "' (file already exists)\n");
-			convCountSkipped++;
-			continue;
-		}
+			return A.compare(B, Qt::CaseInsensitive) < 0;
+		});
+
+		if (RootModified[TypeIdx] != -1)
+			mWatchPaths << RootFolder;
 
-		infile.open(QIODevice::OpenMode::enum_type::ReadOnly);
-		if (!infile.isOpen())
+		for (const QString& Name : Names)
 		{
-			emit OutputReady("Export2Bin: Could not open '" + filepath + "' for reading\n");
-			convCountFailed++;
-			continue;
+			mlScanFolder Folder;
+			Folder.Type = Type;
+			Folder.Name = Name;
+			Folders.append(Folder);
 		}
+	}
 
-		emit OutputReady("Export2Bin: Converting '" + file + "'");
-
-		QByteArray buf = infile.readAll();
-		infile.close();
-
-		Process->start(ExecutablePath, args);
-		Process->write(buf);
-		Process->closeWriteChannel();
+	QVector<mlFileScanEntry> Results(Folders.count());
+	QVector<bool> Done(Folders.count(), false);
+	QMutex Mutex;
+	QWaitCondition Condition;
 
-		QByteArray standardOutputPipeData;
-		QByteArray standardErrorPipeData;
+	QThreadPool Pool;
+	Pool.setMaxThreadCount(qMax(QThread::idealThreadCount(), 8));
 
-		for (;;)
+	for (int FolderIdx = 0; FolderIdx < Folders.count(); FolderIdx++)
+	{
+		Pool.start(new mlFunctionTask([&, FolderIdx]()
 		{
-			Sleep(20);
-
-			if (Process->waitForReadyRead(0))
-			{
-				standardOutputPipeData.append(Process->readAllStandardOutput());
-				standardErrorPipeData.append(Process->readAllStandardError());
-			}
-
-			QProcess::ProcessState State = Process->state();
-			if (State == QProcess::NotRunning)
-				break;
+			mlFileScanEntry Entry;
+			if (!mCancel)
+				Entry = mlFileScanner::ScanFolder(mGamePath, Folders[FolderIdx].Type, Folders[FolderIdx].Name, Index.Find(Folders[FolderIdx].Type, Folders[FolderIdx].Name));
+
+			QMutexLocker Locker(&Mutex);
+			Results[FolderIdx] = Entry;
+			Done[FolderIdx] = true;
+			Condition.wakeAll();
+		}));
+	}
 
-			if (mCancel)
-				Process->kill();
-		}
+	for (int FolderIdx = 0; FolderIdx < Folders.count() && !mCancel; FolderIdx++)
+	{
+		mlFileScanEntry Entry;
 
-		if (Process->exitStatus() != QProcess::NormalExit)
 		{
-			emit OutputReady("ERROR: Process exited abnormally");
-			Success = false;
-			break;
+			QMutexLocker Locker(&Mutex);
+			while (!Done[FolderIdx])
+				Condition.wait(&Mutex);
+			Entry = Results[FolderIdx];
 		}
 
-		if (Process->exitCode() != 0)
-		{
-			emit OutputReady(standardOutputPipeData);
-			emit OutputReady(standardErrorPipeData);
-
-			convCountFailed++;
-
-			if (!mIgnoreErrors)
-			{
-				Success = false;
-				break;
-			}
+		if (Entry.IsValid())
+			emit ItemFound(Entry.Type, Entry.Name, Entry.Zones);
+	}
 
-			continue;
-		}
+	Pool.waitForDone();
 
-		outfile.open(QIODevice::OpenMode::enum_type::WriteOnly);
-		if (!outfile.isOpen())
-		{
-			emit OutputReady("Export2Bin: Could not open '" + target_filepath + "' for writing\n");
-			continue;
-		}
-
-		outfile.write(standardOutputPipeData);
-		outfile.close();
+	if (mCancel)
+		return;
 
-		convCountSuccess++;
+	// Zone files are added and removed in zone_source, a folder that has none yet is watched until it is created
+	for (int FolderIdx = 0; FolderIdx < Folders.count(); FolderIdx++)
+	{
+		QString Folder = mlFileScanner::RootFolder(mGamePath, Folders[FolderIdx].Type) + "/" + Folders[FolderIdx].Name;
+		mWatchPaths << ((Results[FolderIdx].Modified != -1) ? Folder + "/zone_source" : Folder);
 	}
 
-	mSuccess = Success;
-	if (mSuccess)
+	for (int TypeIdx = 0; TypeIdx < 2; TypeIdx++)
 	{
-		QString msg = QString("Export2Bin: Finished!\n\n"
-			"Files Processed: %1\n"
-			"Successes: %2\n"
-			"Skipped: %3\n"
-			"Failures: %4\n").arg(mFiles.count()).arg(convCountSuccess).arg(convCountSkipped).arg(convCountFailed);
-		emit OutputReady(msg);
+		QList<mlFileScanEntry> Entries;
+		for (int FolderIdx = 0; FolderIdx < Folders.count(); FolderIdx++)
+			if (Folders[FolderIdx].Type == Types[TypeIdx])
+				Entries.append(Results[FolderIdx]);
+
+		Index.SetRoot(Types[TypeIdx], RootModified[TypeIdx], Entries);
 	}
+
+	Index.Save();
 }
 
 mlMainWindow::mlMainWindow()
@@ -246,7 +162,16 @@ mlMainWindow::mlMainWindow()
 	QSettings Settings;
 
 	mBuildThread = NULL;
+	mConvertThread = NULL;
+	mFileScanThread = NULL;
+	mFileScanPending = false;
+	mFileListIndexLoaded = false;
 	mBuildLanguage = Settings.value("BuildLanguage", "english").toString();
+	mBuildJobs = Settings.value("BuildJobs", QThread::idealThreadCount()).toInt();
+	mConvertJobs = Settings.value("ConvertJobs", QThread::idealThreadCount()).toInt();
+	mArtifactCacheDir = Settings.value("ArtifactCacheDir").toString();
+	mArtifactCacheSize = Settings.value("ArtifactCacheSize", 20).toInt();
+	mMemoryBudget = Settings.value("MemoryBudget", mlBuildProfiles::DefaultMemoryBudget()).toInt();
 	mTreyarchTheme = Settings.value("UseDarkTheme", false).toBool();
 
 	// Qt prefers '/' over '\\'
@@ -265,6 +190,11 @@ mlMainWindow::mlMainWindow()
 	CreateToolBar();
 
 	mExport2BinGUIWidget = NULL;
+	mExport2BinFileCount = 0;
+	mExport2BinFilesDone = 0;
+	mExport2BinTotalKB = 0;
+	mExport2BinDoneKB = 0;
+	mExport2BinConvertedKB = 0;
 
 	QSplitter* CentralWidget = new QSplitter();
 	CentralWidget->setOrientation(Qt::Vertical);
@@ -275,14 +205,34 @@ mlMainWindow::mlMainWindow()
 	QHBoxLayout* TopLayout = new QHBoxLayout(TopWidget);
 	TopWidget->setLayout(TopLayout);
 
-	mFileListWidget = new QTreeWidget();
+	QVBoxLayout* FileListLayout = new QVBoxLayout();
+	TopLayout->addLayout(FileListLayout);
+
+	mFileListFilterWidget = new QLineEdit();
+	mFileListFilterWidget->setPlaceholderText("Filter Maps and Mods");
+	FileListLayout->addWidget(mFileListFilterWidget);
+
+	// Uniform rows let the view scroll through thousands of maps without measuring each one
+	mFileListModel = new mlFileListModel(this);
+	mFileListWidget = new QTreeView();
 	mFileListWidget->setHeaderHidden(true);
 	mFileListWidget->setUniformRowHeights(true);
 	mFileListWidget->setRootIsDecorated(false);
+	mFileListWidget->setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
 	mFileListWidget->setContextMenuPolicy(Qt::CustomContextMenu);
-	TopLayout->addWidget(mFileListWidget);
+	mFileListWidget->setModel(mFileListModel);
+	mFileListWidget->expandAll();
+	FileListLayout->addWidget(mFileListWidget);
+
+	// Mods are shown with their zones, whether they were just found or the filter brought them back
+	connect(mFileListModel, &QAbstractItemModel::rowsInserted, [this](const QModelIndex& Parent, int First, int Last)
+	{
+		for (int Row = First; Row <= Last; Row++)
+			mFileListWidget->expand(mFileListModel->index(Row, 0, Parent));
+	});
 
 	connect(mFileListWidget, SIGNAL(customContextMenuRequested(const QPoint&)), this, SLOT(ContextMenuRequested()));
+	connect(mFileListFilterWidget, SIGNAL(textChanged(const QString&)), this, SLOT(OnFileListFilterChanged()));
 
 	QVBoxLayout* ActionsLayout = new QVBoxLayout();
 	TopLayout->addLayout(ActionsLayout);
@@ -324,6 +274,11 @@ mlMainWindow::mlMainWindow()
 	connect(mBuildButton, SIGNAL(clicked()), mActionEditBuild, SLOT(trigger()));
 	ActionsLayout->addWidget(mBuildButton);
 
+	mPlanButton = new QPushButton("Plan");
+	mPlanButton->setToolTip("Show what a build would run and how long it should take");
+	connect(mPlanButton, SIGNAL(clicked()), mActionEditPlan, SLOT(trigger()));
+	ActionsLayout->addWidget(mPlanButton);
+
 	mDvarsButton = new QPushButton("Dvars");
 	connect(mDvarsButton, SIGNAL(clicked()), this, SLOT(OnEditDvars()));
 	ActionsLayout->addWidget(mDvarsButton);
@@ -335,14 +290,41 @@ mlMainWindow::mlMainWindow()
 	mIgnoreErrorsWidget = new QCheckBox("Ignore Errors");
 	ActionsLayout->addWidget(mIgnoreErrorsWidget);
 
+	mForceRebuildWidget = new QCheckBox("Force Rebuild");
+	mForceRebuildWidget->setToolTip("Run every step even if its inputs did not change since the last build");
+	ActionsLayout->addWidget(mForceRebuildWidget);
+
+	mForceUpdateDBWidget = new QCheckBox("Force GDT Update");
+	mForceUpdateDBWidget->setToolTip("Run gdtdb /update even if no GDT changed since the last update");
+	ActionsLayout->addWidget(mForceUpdateDBWidget);
+
+	mAbortOnFatalErrorWidget = new QCheckBox("Abort on Fatal Error");
+	mAbortOnFatalErrorWidget->setToolTip("Cancel the rest of the build as soon as a tool reports a fatal error, such as a missing asset");
+	ActionsLayout->addWidget(mAbortOnFatalErrorWidget);
+
 	ActionsLayout->addStretch(1);
 
-	mOutputWidget = new QPlainTextEdit(this);
-	mOutputWidget->setReadOnly(true);
+	mDiagnosticsLabel = new QLabel();
+	ActionsLayout->addWidget(mDiagnosticsLabel);
+
+	mNextErrorButton = new QPushButton("Next Error");
+	connect(mNextErrorButton, SIGNAL(clicked()), this, SLOT(OnNextError()));
+	ActionsLayout->addWidget(mNextErrorButton);
+
+	mOutputWidget = new mlOutputWidget(this);
 	CentralWidget->addWidget(mOutputWidget);
 
 	setCentralWidget(CentralWidget);
 
+	mProgressWidget = new QProgressBar();
+	mProgressWidget->setRange(0, 100);
+	mProgressWidget->setMaximumWidth(200);
+	mProgressWidget->hide();
+	statusBar()->addPermanentWidget(mProgressWidget);
+
+	mRemainingTimeLabel = new QLabel();
+	statusBar()->addPermanentWidget(mRemainingTimeLabel);
+
 	mShippedMapList << "mp_aerospace" <<  "mp_apartments" << "mp_arena" << "mp_banzai" << "mp_biodome" << "mp_chinatown" << "mp_city" << "mp_conduit" << "mp_crucible" << "mp_cryogen" << "mp_ethiopia" << "mp_freerun_01" << "mp_freerun_02" << "mp_freerun_03" << "mp_freerun_04" << "mp_havoc" << "mp_infection" << "mp_kung_fu" << "mp_metro" << "mp_miniature" << "mp_nuketown_x" << "mp_redwood" << "mp_rise" << "mp_rome" << "mp_ruins" << "mp_sector" << "mp_shrine" << "mp_skyjacked" << "mp_spire" << "mp_stronghold" << "mp_veiled" << "mp_waterpark" << "mp_western" << "zm_castle" << "zm_factory" << "zm_genesis" << "zm_island" << "zm_levelcommon" << "zm_stalingrad" << "zm_zod";
 
 	Settings.beginGroup("MainWindow");
@@ -357,11 +339,24 @@ mlMainWindow::mlMainWindow()
 	connect(&mTimer, SIGNAL(timeout()), this, SLOT(SteamUpdate()));
 	mTimer.start(1000);
 
+	DiagnosticsUpdated(0, 0);
+
+	// Maps and mods created outside the launcher, by a pull or a teammate, show up once the folders are quiet again
+	mFileListWatchTimer.setSingleShot(true);
+	mFileListWatchTimer.setInterval(500);
+	connect(&mFileListWatcher, SIGNAL(directoryChanged(QString)), &mFileListWatchTimer, SLOT(start()));
+	connect(&mFileListWatchTimer, SIGNAL(timeout()), this, SLOT(PopulateFileList()));
+
 	PopulateFileList();
 }
 
 mlMainWindow::~mlMainWindow()
 {
+	if (mFileScanThread)
+	{
+		mFileScanThread->Cancel();
+		mFileScanThread->wait();
+	}
 }
 
 void mlMainWindow::CreateActions()
@@ -390,6 +385,10 @@ void mlMainWindow::CreateActions()
 	mActionEditBuild->setShortcut(QKeySequence("Ctrl+B"));
 	connect(mActionEditBuild, SIGNAL(triggered()), this, SLOT(OnEditBuild()));
 
+	mActionEditPlan = new QAction("&Plan Build...", this);
+	mActionEditPlan->setShortcut(QKeySequence("Ctrl+Shift+B"));
+	connect(mActionEditPlan, SIGNAL(triggered()), this, SLOT(OnEditPlan()));
+
 	mActionEditPublish = new QAction(QIcon(":/resources/upload.png"), "Publish", this);
 	mActionEditPublish->setShortcut(QKeySequence("Ctrl+P"));
 	connect(mActionEditPublish, SIGNAL(triggered()), this, SLOT(OnEditPublish()));
@@ -397,6 +396,9 @@ void mlMainWindow::CreateActions()
 	mActionEditOptions = new QAction("&Options...", this);
 	connect(mActionEditOptions, SIGNAL(triggered()), this, SLOT(OnEditOptions()));
 
+	mActionEditBuildProfiles = new QAction("Build &Profiles...", this);
+	connect(mActionEditBuildProfiles, SIGNAL(triggered()), this, SLOT(OnEditBuildProfiles()));
+
 	mActionHelpAbout = new QAction("&About...", this);
 	connect(mActionHelpAbout, SIGNAL(triggered()), this, SLOT(OnHelpAbout()));
 }
@@ -417,8 +419,10 @@ void mlMainWindow::CreateMenu()
 
 	QMenu* EditMenu = new QMenu("&Edit", MenuBar);
 	EditMenu->addAction(mActionEditBuild);
+	EditMenu->addAction(mActionEditPlan);
 	EditMenu->addAction(mActionEditPublish);
 	EditMenu->addSeparator();
+	EditMenu->addAction(mActionEditBuildProfiles);
 	EditMenu->addAction(mActionEditOptions);
 	MenuBar->addAction(EditMenu->menuAction());
 
@@ -465,11 +469,19 @@ void mlMainWindow::InitExport2BinGUI()
 	groupBoxLayout->addWidget(label);
 	groupBox->setLayout(groupBoxLayout);
 
-	mExport2BinOverwriteWidget = new QCheckBox("&Overwrite Existing Files", widget);
-	gridLayout->addWidget(mExport2BinOverwriteWidget, 1, 0);
-	
+	QHBoxLayout* overwriteLayout = new QHBoxLayout();
+	QLabel* overwriteLabel = new QLabel("&Overwrite Existing Files:", widget);
+	mExport2BinOverwriteWidget = new QComboBox(widget);
+	mExport2BinOverwriteWidget->addItems(QStringList() << "Always" << "Never" << "Only if Changed");
+	overwriteLabel->setBuddy(mExport2BinOverwriteWidget);
+	overwriteLayout->addWidget(overwriteLabel);
+	overwriteLayout->addWidget(mExport2BinOverwriteWidget);
+	gridLayout->addLayout(overwriteLayout, 1, 0);
+
+	// Older versions only had a checkbox for always overwriting
 	QSettings Settings;
-	mExport2BinOverwriteWidget->setChecked(Settings.value("Export2Bin_OverwriteFiles", true).toBool());
+	int defaultMode = Settings.value("Export2Bin_OverwriteFiles", true).toBool() ? ML_OVERWRITE_ALWAYS : ML_OVERWRITE_NEVER;
+	mExport2BinOverwriteWidget->setCurrentIndex(Settings.value("Export2Bin_OverwriteMode", defaultMode).toInt());
 
 	QHBoxLayout* dirLayout = new QHBoxLayout();
 	QLabel* dirLabel = new QLabel("Ouput Directory:", widget);
@@ -481,7 +493,7 @@ void mlMainWindow::InitExport2BinGUI()
 	mExport2BinTargetDirWidget->setText(Settings.value("Export2Bin_TargetDir", defaultPath.absolutePath()).toString());
 
 	connect(dirBrowseButton, SIGNAL(clicked()), this, SLOT(OnExport2BinChooseDirectory()));
-	connect(mExport2BinOverwriteWidget, SIGNAL(clicked()), this, SLOT(OnExport2BinToggleOverwriteFiles()));
+	connect(mExport2BinOverwriteWidget, SIGNAL(currentIndexChanged(int)), this, SLOT(OnExport2BinOverwriteModeChanged()));
 
 	dirBrowseButton->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
 	dirLayout->addWidget(dirLabel);
@@ -490,9 +502,65 @@ void mlMainWindow::InitExport2BinGUI()
 
 	gridLayout->addLayout(dirLayout, 2, 0);
 
+	mExport2BinPreflightWidget = new QCheckBox("&Validate Exports While Converting", widget);
+	mExport2BinPreflightWidget->setToolTip("Check that each export is well formed as it is passed to export2bin, a broken export is stopped at the first error");
+	mExport2BinPreflightWidget->setChecked(Settings.value("Export2Bin_Preflight", true).toBool());
+	connect(mExport2BinPreflightWidget, &QCheckBox::clicked, [this]()
+	{
+		QSettings().setValue("Export2Bin_Preflight", mExport2BinPreflightWidget->isChecked());
+	});
+	gridLayout->addWidget(mExport2BinPreflightWidget, 3, 0);
+
+	QHBoxLayout* watchLayout = new QHBoxLayout();
+	mExport2BinWatchWidget = new QCheckBox("&Watch Folder:", widget);
+	mExport2BinWatchWidget->setToolTip("Automatically convert exports that are added or changed in this folder or its subfolders");
+	mExport2BinWatchDirWidget = new QLineEdit(widget);
+	mExport2BinWatchDirWidget->setText(Settings.value("Export2Bin_WatchDir").toString());
+	QToolButton* watchBrowseButton = new QToolButton(widget);
+	watchBrowseButton->setText("...");
+	watchBrowseButton->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+
+	connect(watchBrowseButton, SIGNAL(clicked()), this, SLOT(OnExport2BinChooseWatchDirectory()));
+	connect(mExport2BinWatchWidget, SIGNAL(clicked()), this, SLOT(OnExport2BinToggleWatch()));
+	connect(mExport2BinWatchDirWidget, SIGNAL(editingFinished()), this, SLOT(OnExport2BinToggleWatch()));
+
+	watchLayout->addWidget(mExport2BinWatchWidget);
+	watchLayout->addWidget(mExport2BinWatchDirWidget);
+	watchLayout->addWidget(watchBrowseButton);
+
+	gridLayout->addLayout(watchLayout, 4, 0);
+
+	mExport2BinProgressWidget = new QProgressBar(widget);
+	mExport2BinProgressWidget->setRange(0, 1);
+	mExport2BinProgressWidget->setValue(0);
+	gridLayout->addWidget(mExport2BinProgressWidget, 5, 0);
+
+	mExport2BinRateLabel = new QLabel(widget);
+	gridLayout->addWidget(mExport2BinRateLabel, 6, 0);
+
+	mExport2BinStatsWidget = new QTableWidget(0, 7, widget);
+	mExport2BinStatsWidget->setHorizontalHeaderLabels(QStringList() << "File" << "Status" << "Exit Code" << "Time (ms)" << "In (KB)" << "Out (KB)" << "Assets");
+	mExport2BinStatsWidget->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+	mExport2BinStatsWidget->verticalHeader()->hide();
+	mExport2BinStatsWidget->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	mExport2BinStatsWidget->setSelectionBehavior(QAbstractItemView::SelectRows);
+	mExport2BinStatsWidget->setSortingEnabled(true);
+	mExport2BinStatsWidget->sortByColumn(3, Qt::DescendingOrder);
+	gridLayout->addWidget(mExport2BinStatsWidget, 7, 0);
+
+	QPushButton* exportStatsButton = new QPushButton("Export &CSV...", widget);
+	connect(exportStatsButton, SIGNAL(clicked()), this, SLOT(OnExport2BinExportStats()));
+	gridLayout->addWidget(exportStatsButton, 8, 0, Qt::AlignRight);
+
+	// Exporters write files in bursts, changes are only picked up once a folder has been quiet for a moment
+	mExport2BinWatchTimer.setSingleShot(true);
+	mExport2BinWatchTimer.setInterval(1000);
+	connect(&mExport2BinWatchTimer, SIGNAL(timeout()), this, SLOT(OnExport2BinWatchTimeout()));
+	connect(&mExport2BinWatcher, SIGNAL(directoryChanged(QString)), this, SLOT(OnExport2BinWatchDirectoryChanged(QString)));
+
 	groupBox->setAcceptDrops(true);
 
-	dock->resize(QSize(256, 256));
+	dock->resize(QSize(512, 512));
 
 	mExport2BinGUIWidget = dock;
 }
@@ -518,94 +586,206 @@ void mlMainWindow::UpdateDB()
 	if (mBuildThread)
 		return;
 
-	QList<QPair<QString, QStringList>> Commands;
-	Commands.append(QPair<QString, QStringList>(QString("%1/gdtdb/gdtdb.exe").arg(mToolsPath), QStringList() << "/update"));
+	mlBuildOptions Options = BuildOptions();
+	mlBuildGraph Graph;
+	Graph.AddUpdateDBStep(Options);
+
+	StartBuildThread(Graph, Options);
+}
 
-	StartBuildThread(Commands);
+mlBuildOptions mlMainWindow::BuildOptions() const
+{
+	mlBuildOptions Options;
+	Options.Compile = mCompileEnabledWidget->isChecked();
+	Options.CompileEntsOnly = (mCompileModeWidget->currentIndex() == 0);
+	Options.Light = mLightEnabledWidget->isChecked();
+	Options.LightQuality = mLightQualityWidget->currentIndex();
+	Options.Link = mLinkEnabledWidget->isChecked();
+	Options.Run = mRunEnabledWidget->isChecked();
+	Options.RunOptions = mRunOptionsWidget->text();
+	Options.RunDvars = mRunDvars;
+	Options.Language = mBuildLanguage;
+	Options.ForceUpdateDB = mForceUpdateDBWidget->isChecked();
+	Options.IgnoreErrors = mIgnoreErrorsWidget->isChecked();
+	Options.ForceRebuild = mForceRebuildWidget->isChecked();
+	Options.AbortOnFatalError = mAbortOnFatalErrorWidget->isChecked();
+	Options.MaxJobs = mBuildJobs;
+	Options.GamePath = mGamePath;
+	Options.ToolsPath = mToolsPath;
+	Options.ArtifactCacheDir = mArtifactCacheDir;
+	Options.ArtifactCacheSize = (qint64)mArtifactCacheSize * 1024 * 1024 * 1024;
+	Options.MemoryBudget = (qint64)mMemoryBudget * 1024 * 1024 * 1024;
+
+	return Options;
 }
 
-void mlMainWindow::StartBuildThread(const QList<QPair<QString, QStringList>>& Commands)
+void mlMainWindow::StartBuildThread(const mlBuildGraph& Graph, const mlBuildOptions& Options)
 {
 	mBuildButton->setText("Cancel");
-	mOutputWidget->clear();
+	mOutputWidget->ClearOutput();
+	mWindowSessionLogs.clear();
+	DiagnosticsUpdated(0, 0);
+	StartSessionLog(mBuildLog);
+
+	mPlanButton->setEnabled(false);
+	mProgressWidget->setValue(0);
+	mProgressWidget->show();
+	mRemainingTimeLabel->clear();
 
-	mBuildThread = new mlBuildThread(Commands, mIgnoreErrorsWidget->isChecked());
+	mBuildThread = new mlBuildThread(Graph, Options);
 	connect(mBuildThread, SIGNAL(OutputReady(QString)), this, SLOT(BuildOutputReady(QString)));
+	connect(mBuildThread, SIGNAL(ProgressUpdated(int, int)), this, SLOT(BuildProgressUpdated(int, int)));
+	connect(mBuildThread, SIGNAL(DiagnosticsUpdated(int, int)), this, SLOT(DiagnosticsUpdated(int, int)));
 	connect(mBuildThread, SIGNAL(finished()), this, SLOT(BuildFinished()));
 	mBuildThread->start();
 }
 
-void mlMainWindow::StartConvertThread(QStringList& pathList, QString& outputDir, bool allowOverwrite)
+void mlMainWindow::StartConvertThread(QStringList& pathList, QString& outputDir, mlOverwriteMode overwriteMode)
 {
-	mConvertThread = new mlConvertThread(pathList, outputDir, true, allowOverwrite);
-	connect(mConvertThread, SIGNAL(OutputReady(QString)), this, SLOT(BuildOutputReady(QString)));
-	connect(mConvertThread, SIGNAL(finished()), this, SLOT(BuildFinished()));
+	DiagnosticsUpdated(0, 0);
+	StartSessionLog(mConvertLog);
+
+	mConvertThread = new mlConvertThread(pathList, outputDir, true, overwriteMode, mConvertJobs);
+	mConvertThread->SetPreflight(mExport2BinPreflightWidget->isChecked());
+	connect(mConvertThread, SIGNAL(OutputReady(QString)), this, SLOT(ConvertOutputReady(QString)));
+	connect(mConvertThread, SIGNAL(DiagnosticsUpdated(int, int)), this, SLOT(DiagnosticsUpdated(int, int)));
+	connect(mConvertThread, SIGNAL(ConvertStarted(int, int)), this, SLOT(ConvertStarted(int, int)));
+	connect(mConvertThread, SIGNAL(FileFinished(QString, int, int, int, int, int, QString)), this, SLOT(ConvertFileFinished(QString, int, int, int, int, int, QString)));
+	connect(mConvertThread, SIGNAL(finished()), this, SLOT(ConvertFinished()));
 	mConvertThread->start();
 }
 
-void mlMainWindow::PopulateFileList()
+// Every build and conversion is written to its own log in logs/sessions as it runs, only the most recent ones are kept.
+// Builds and conversions have separate writers so that one can run while the other is logging, the window shows the
+// output of every session started since the last build.
+void mlMainWindow::StartSessionLog(mlLogWriter& SessionLog)
 {
-	mFileListWidget->clear();
+	const int MaxSessionLogs = 20;
+	QDir SessionsDir("logs/sessions");
+
+	QFileInfoList SessionLogs = SessionsDir.entryInfoList(QStringList() << "modlog_*.txt", QDir::Files, QDir::Time);
+	for (int LogIdx = MaxSessionLogs - 1; LogIdx < SessionLogs.count(); LogIdx++)
+		QFile::remove(SessionLogs[LogIdx].absoluteFilePath());
+
+	SessionLog.Open(SessionsDir.filePath(QString("modlog_%1.txt").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd_HH_mm_ss_zzz"))));
+	mWindowSessionLogs.append(SessionLog.FileName());
+}
 
-	QString UserMapsFolder = QDir::cleanPath(QString("%1/usermaps/").arg(mGamePath));
-	QStringList UserMaps = QDir(UserMapsFolder).entryList(QDir::AllDirs | QDir::NoDotAndDotDot);
-	QTreeWidgetItem* MapsRootItem = new QTreeWidgetItem(mFileListWidget, QStringList() << "Maps");
+// The list is updated in place as the scan reports what it finds, so items that are still there keep their check state and selection
+void mlMainWindow::PopulateFileList()
+{
+	if (mFileScanThread)
+	{
+		mFileScanPending = true;
+		return;
+	}
 
-	QFont Font = MapsRootItem->font(0);
-	Font.setBold(true);
-	MapsRootItem->setFont(0, Font);
+	QString IndexFileName = mlFileIndex::DefaultFileName(mToolsPath);
 
-	for (QString MapName : UserMaps)
+	if (!mFileListIndexLoaded)
 	{
-		QString ZoneFileName = QString("%1/%2/zone_source/%3.zone").arg(UserMapsFolder, MapName, MapName);
+		mFileListIndexLoaded = true;
+
+		// The list from the last run is shown right away, the scan then corrects whatever changed since
+		mlFileIndex Index(IndexFileName, mGamePath);
+		if (Index.Load())
+			for (const mlFileScanEntry& Entry : Index.Entries())
+				if (Entry.IsValid())
+					FileScanItemFound(Entry.Type, Entry.Name, Entry.Zones);
+	}
 
-		if (QFileInfo(ZoneFileName).isFile())
-		{
-			QTreeWidgetItem* MapItem = new QTreeWidgetItem(MapsRootItem, QStringList() << MapName);
-			MapItem->setCheckState(0, Qt::Unchecked);
-			MapItem->setData(0, Qt::UserRole, ML_ITEM_MAP);
-		}
+	mStaleFileListItems = QSet<QString>::fromList(mFileListModel->Keys());
+	mFileScanPending = false;
+
+	mFileScanThread = new mlFileScanThread(mGamePath, IndexFileName);
+	connect(mFileScanThread, SIGNAL(ItemFound(int, QString, QStringList)), this, SLOT(FileScanItemFound(int, QString, QStringList)));
+	connect(mFileScanThread, SIGNAL(finished()), this, SLOT(FileScanFinished()));
+	mFileScanThread->start();
+}
+
+void mlMainWindow::FileScanItemFound(int Type, const QString& Name, const QStringList& Zones)
+{
+	if (Type == ML_ITEM_MAP)
+	{
+		mFileListModel->AddMap(Name);
+		mStaleFileListItems.remove(mlFileListModel::MapKey(Name));
+		return;
 	}
 
-	QString ModsFolder = QDir::cleanPath(QString("%1/mods/").arg(mGamePath));
-	QStringList Mods = QDir(ModsFolder).entryList(QDir::AllDirs | QDir::NoDotAndDotDot);
-	QTreeWidgetItem* ModsRootItem = new QTreeWidgetItem(mFileListWidget, QStringList() << "Mods");
-	ModsRootItem->setFont(0, Font);
-	const char* Files[4] = { "core_mod", "mp_mod", "cp_mod", "zm_mod" };
+	QString ModKey = mlFileListModel::ModKey(Name);
+	bool NewMod = !mFileListModel->Contains(ModKey);
+
+	mFileListModel->AddMod(Name, Zones);
+	if (NewMod)
+		mFileListWidget->expand(mFileListModel->IndexOf(ModKey));
 
-	for (QString ModName : Mods)
+	mStaleFileListItems.remove(ModKey);
+	for (const QString& Zone : Zones)
+		mStaleFileListItems.remove(mlFileListModel::ZoneKey(Name, Zone));
+}
+
+// Whatever the scan did not report is gone, zones are removed before the mods they belong to
+void mlMainWindow::FileScanFinished()
+{
+	QStringList StaleKeys = mStaleFileListItems.toList();
+	std::sort(StaleKeys.begin(), StaleKeys.end(), [](const QString& A, const QString& B)
 	{
-		QTreeWidgetItem* ParentItem = NULL;
+		return A.count('/') > B.count('/');
+	});
 
-		for (int FileIdx = 0; FileIdx < 4; FileIdx++)
-		{
-			QString ZoneFileName = QString("%1/%2/zone_source/%3.zone").arg(ModsFolder, ModName, Files[FileIdx]);
+	for (const QString& Key : StaleKeys)
+		mFileListModel->Remove(Key);
 
-			if (QFileInfo(ZoneFileName).isFile())
-			{
-				if (!ParentItem)
-					ParentItem = new QTreeWidgetItem(ModsRootItem, QStringList() << ModName);
+	mStaleFileListItems.clear();
 
-				QTreeWidgetItem* ModItem = new QTreeWidgetItem(ParentItem, QStringList() << Files[FileIdx]);
-				ModItem->setCheckState(0, Qt::Unchecked);
-				ModItem->setData(0, Qt::UserRole, ML_ITEM_MOD);
-			}
-		}
-	}
+	// Only the folders that were added or went away are changed on the watcher
+	QSet<QString> WatchPaths = QSet<QString>::fromList(mFileScanThread->WatchPaths());
+	QSet<QString> WatchedPaths = QSet<QString>::fromList(mFileListWatcher.directories());
 
-	mFileListWidget->expandAll();
+	QStringList RemovedPaths = (WatchedPaths - WatchPaths).toList();
+	QStringList AddedPaths = (WatchPaths - WatchedPaths).toList();
+	if (!RemovedPaths.isEmpty())
+		mFileListWatcher.removePaths(RemovedPaths);
+	if (!AddedPaths.isEmpty())
+		mFileListWatcher.addPaths(AddedPaths);
+
+	mFileScanThread->deleteLater();
+	mFileScanThread = NULL;
+
+	if (mFileScanPending)
+		PopulateFileList();
 }
 
-void mlMainWindow::ContextMenuRequested()
+mlBuildItem mlMainWindow::SelectedFileListItem() const
 {
-	QList<QTreeWidgetItem*> ItemList = mFileListWidget->selectedItems();
-	if (ItemList.isEmpty())
-		return;
+	QModelIndexList Indexes = mFileListWidget->selectionModel()->selectedIndexes();
+	if (Indexes.isEmpty())
+		return mlBuildItem();
+
+	return mFileListModel->Item(Indexes[0]);
+}
 
-	QTreeWidgetItem* Item = ItemList[0];
-	QString ItemType = (Item->data(0, Qt::UserRole).toInt() == ML_ITEM_MAP) ? "Map" : "Mod";
+// The selection is kept if the selected item is still shown after filtering
+void mlMainWindow::OnFileListFilterChanged()
+{
+	QString SelectedKey = mFileListModel->Key(mFileListWidget->currentIndex());
+
+	mFileListModel->SetFilter(mFileListFilterWidget->text());
+
+	QModelIndex Selected = mFileListModel->IndexOf(SelectedKey);
+	if (Selected.isValid())
+	{
+		mFileListWidget->setCurrentIndex(Selected);
+		mFileListWidget->scrollTo(Selected);
+	}
+}
 
-	if (Item->data(0, Qt::UserRole).toInt() == ML_ITEM_UNKNOWN)
+void mlMainWindow::ContextMenuRequested()
+{
+	mlBuildItem Item = SelectedFileListItem();
+	QString ItemType = (Item.Type == ML_ITEM_MAP) ? "Map" : "Mod";
+
+	if (Item.Type == ML_ITEM_UNKNOWN)
 		return;
 
 	QIcon GameIcon(":/resources/BlackOps3.png");
@@ -613,7 +793,7 @@ void mlMainWindow::ContextMenuRequested()
 	QMenu* Menu = new QMenu;
 	Menu->addAction(GameIcon, QString("Run %1").arg(ItemType), this, SLOT(OnRunMapOrMod()));
 
-	if (Item->data(0, Qt::UserRole).toInt() == ML_ITEM_MAP)
+	if (Item.Type == ML_ITEM_MAP)
 		Menu->addAction(mActionFileLevelEditor);
 
 	Menu->addAction("Edit Zone File", this, SLOT(OnOpenZoneFile()));
@@ -638,10 +818,10 @@ void mlMainWindow::OnFileLevelEditor()
 	QProcess* Process = new QProcess();
 	connect(Process, SIGNAL(finished(int)), Process, SLOT(deleteLater()));
 
-	QList<QTreeWidgetItem*> ItemList = mFileListWidget->selectedItems();
-	if (ItemList.count() && ItemList[0]->data(0, Qt::UserRole).toInt() == ML_ITEM_MAP)
+	mlBuildItem Item = SelectedFileListItem();
+	if (Item.Type == ML_ITEM_MAP)
 	{
-		QString MapName = ItemList[0]->text(0);
+		QString MapName = Item.Name;
 		Process->start(QString("%1/bin/radiant_modtools.exe").arg(mToolsPath), QStringList() << QString("%1/map_source/%2/%3.map").arg(mGamePath, MapName.left(2), MapName));
 	}
 	else
@@ -786,6 +966,11 @@ void mlMainWindow::OnFileNew()
 		QMessageBox::information(this, "Error", "Error creating map files.");
 }
 
+QList<mlBuildItem> mlMainWindow::CheckedBuildItems() const
+{
+	return mFileListModel->CheckedItems();
+}
+
 void mlMainWindow::OnEditBuild()
 {
 	if (mBuildThread)
@@ -794,184 +979,156 @@ void mlMainWindow::OnEditBuild()
 		return;
 	}
 
-	QList<QPair<QString, QStringList>> Commands;
-	bool UpdateAdded = false;
+	mlBuildOptions Options = BuildOptions();
+	mlBuildGraph Graph = mlBuildGraph::Create(CheckedBuildItems(), Options);
 
-	auto AddUpdateDBCommand = [&]()
+	if (Graph.IsEmpty())
 	{
-		if (!UpdateAdded)
-		{
-			Commands.append(QPair<QString, QStringList>(QString("%1/gdtdb/gdtdb.exe").arg(mToolsPath), QStringList() << "/update"));
-			UpdateAdded = true;
-		}
-	};
+		QMessageBox::information(this, "No Tasks", "Please selected at least one file from the list and one action to be performed.");
+		return;
+	}
 
-	QList<QTreeWidgetItem*> CheckedItems;
+	StartBuildThread(Graph, Options);
+}
 
-	std::function<void (QTreeWidgetItem*)> SearchCheckedItems=[&](QTreeWidgetItem* ParentItem) -> void
-	{
-		for (int ChildIdx = 0; ChildIdx < ParentItem->childCount(); ChildIdx++)
-		{
-			QTreeWidgetItem* Child = ParentItem->child(ChildIdx);
-			if (Child->checkState(0) == Qt::Checked)
-				CheckedItems.append(Child);
-			else
-				SearchCheckedItems(Child);
-		}
-	};
+static QString FormatDuration(qint64 Milliseconds)
+{
+	qint64 Seconds = (Milliseconds + 999) / 1000;
 
-	SearchCheckedItems(mFileListWidget->invisibleRootItem());
-	QString LastMap, LastMod;
+	if (Seconds < 60)
+		return QString("%1s").arg(Seconds);
 
-	QStringList LanguageArgs;
-	LanguageArgs;
+	if (Seconds < 3600)
+		return QString("%1m %2s").arg(Seconds / 60).arg(Seconds % 60);
 
-	if (mBuildLanguage != "All")
-		LanguageArgs << "-language" << mBuildLanguage;
-	else for (const QString& Language : gLanguages)
-		LanguageArgs << "-language" << Language;
+	return QString("%1h %2m").arg(Seconds / 3600).arg((Seconds % 3600) / 60);
+}
 
-	for (QTreeWidgetItem* Item : CheckedItems)
-	{
-		if (Item->data(0, Qt::UserRole).toInt() == ML_ITEM_MAP)
-		{
-			QString MapName = Item->text(0);
+// Shows what a build of the checked items would run without running anything, it can be started from there
+void mlMainWindow::OnEditPlan()
+{
+	if (mBuildThread)
+		return;
 
-			if (mCompileEnabledWidget->isChecked())
-			{
-				AddUpdateDBCommand();
+	mlBuildOptions Options = BuildOptions();
+	mlBuildGraph Graph = mlBuildGraph::Create(CheckedBuildItems(), Options);
 
-				QStringList Args;
-				Args << "-platform" << "pc";
+	if (Graph.IsEmpty())
+	{
+		QMessageBox::information(this, "No Tasks", "Please selected at least one file from the list and one action to be performed.");
+		return;
+	}
 
-				if (mCompileModeWidget->currentIndex() == 0)
-					Args << "-onlyents";
-				else
-					Args << "-navmesh" << "-navvolume";
+	// Inputs that changed since the last build are hashed again, which can take a moment for large maps
+	QApplication::setOverrideCursor(Qt::WaitCursor);
+	mlBuildPlan Plan(Graph, Options);
+	QApplication::restoreOverrideCursor();
 
-				Args << "-loadFrom" << QString("%1\\map_source\\%2\\%3.map").arg(mGamePath, MapName.left(2), MapName);
-				Args << QString("%1\\share\\raw\\maps\\%2\\%3.d3dbsp").arg(mGamePath, MapName.left(2), MapName);
+	QDialog Dialog(this, Qt::WindowTitleHint | Qt::WindowSystemMenuHint | Qt::WindowCloseButtonHint);
+	Dialog.setWindowTitle("Build Plan");
+	Dialog.resize(900, 500);
 
-				Commands.append(QPair<QString, QStringList>(QString("%1\\bin\\cod2map64.exe").arg(mToolsPath), Args));
-			}
+	QVBoxLayout* Layout = new QVBoxLayout(&Dialog);
 
-			if (mLightEnabledWidget->isChecked())
-			{
-				AddUpdateDBCommand();
+	QTreeWidget* StepsWidget = new QTreeWidget(&Dialog);
+	StepsWidget->setColumnCount(5);
+	StepsWidget->setHeaderLabels(QStringList() << "Step" << "Action" << "Estimate" << "Depends On" << "Command");
+	StepsWidget->setRootIsDecorated(false);
+	StepsWidget->setUniformRowHeights(true);
 
-				QStringList Args;
-				Args << "-ledSilent";
+	int RunCount = 0, UpToDateCount = 0, RestoreCount = 0;
+	const char* ActionNames[] = { "Run", "Restore from cache", "Up to date" };
 
-				switch (mLightQualityWidget->currentIndex())
-				{
-				case 0:
-					Args << "+low";
-					break;
+	for (int StepIdx = 0; StepIdx < Graph.Count(); StepIdx++)
+	{
+		const mlBuildStep& Step = Graph.Step(StepIdx);
+		mlPlanAction Action = Plan.Action(StepIdx);
 
-				default:
-				case 1:
-					Args << "+medium";
-					break;
+		QStringList Dependencies;
+		for (int DependencyIdx : Step.Dependencies)
+			Dependencies << Graph.Step(DependencyIdx).Name;
 
-				case 2:
-					Args << "+high";
-					break;
-				}
+		QString Estimate;
+		if (Action == ML_PLAN_RUN && Step.Name != "run")
+		{
+			if (!Plan.EstimatedDuration(StepIdx))
+				Estimate = "Unknown";
+			else if (Plan.IsFallback(StepIdx))
+				Estimate = QString("About %1, never built").arg(FormatDuration(Plan.EstimatedDuration(StepIdx)));
+			else
+				Estimate = FormatDuration(Plan.EstimatedDuration(StepIdx));
+		}
 
-				Args << "+localprobes" << "+forceclean" << "+recompute" << QString("%1/map_source/%2/%3.map").arg(mGamePath, MapName.left(2), MapName);
-				Commands.append(QPair<QString, QStringList>(QString("%1/bin/radiant_modtools.exe").arg(mToolsPath), Args));
-			}
+		QString Command = Step.Executable + ' ' + Step.Arguments.join(' ');
 
-			if (mLinkEnabledWidget->isChecked())
-			{
-				AddUpdateDBCommand();
+		QTreeWidgetItem* Item = new QTreeWidgetItem(StepsWidget, QStringList() << Step.Name << ActionNames[Action] << Estimate << Dependencies.join(", ") << Command);
+		Item->setToolTip(4, Command);
 
-				Commands.append(QPair<QString, QStringList>(QString("%1/bin/linker_modtools.exe").arg(mToolsPath), QStringList() << LanguageArgs << "-modsource" << MapName));
-			}
+		if (Action != ML_PLAN_RUN)
+			for (int Column = 0; Column < StepsWidget->columnCount(); Column++)
+				Item->setForeground(Column, StepsWidget->palette().brush(QPalette::Disabled, QPalette::Text));
 
-			LastMap = MapName;
-		}
+		if (Action == ML_PLAN_RUN)
+			RunCount++;
+		else if (Action == ML_PLAN_RESTORE)
+			RestoreCount++;
 		else
-		{
-			QString ModName = Item->parent()->text(0);
-
-			if (mLinkEnabledWidget->isChecked())
-			{
-				AddUpdateDBCommand();
-
-				QString ZoneName = Item->text(0);
-				Commands.append(QPair<QString, QStringList>(QString("%1/bin/linker_modtools.exe").arg(mToolsPath), QStringList() << LanguageArgs << "-fs_game" << ModName << "-modsource" << ZoneName));
-			}
-
-			LastMod = ModName;
-		}
+			UpToDateCount++;
 	}
 
-	if (mRunEnabledWidget->isChecked() && (!LastMod.isEmpty() || !LastMap.isEmpty()))
-	{
-		QStringList Args;
+	for (int Column = 0; Column < StepsWidget->columnCount() - 1; Column++)
+		StepsWidget->resizeColumnToContents(Column);
 
-		if(!mRunDvars.isEmpty())
-			Args << mRunDvars;
+	QString Summary = QString("%1 step(s) will run, %2 will be restored from the artifact cache and %3 are up to date.").arg(RunCount).arg(RestoreCount).arg(UpToDateCount);
+	if (Plan.HasHistory())
+		Summary += QString(" Estimated time: %1.").arg(FormatDuration(Plan.EstimatedTotal()));
+	else
+		Summary += QString(" Some steps have never been built, going by other maps it should take about %1 but the time is unknown.").arg(FormatDuration(Plan.EstimatedTotal()));
 
-		Args << "+set" << "fs_game" << (LastMod.isEmpty() ? LastMap : LastMod);
+	QLabel* SummaryLabel = new QLabel(Summary);
+	SummaryLabel->setWordWrap(true);
+	Layout->addWidget(SummaryLabel);
+	Layout->addWidget(StepsWidget);
 
-		if (!LastMap.isEmpty())
-			Args << "+devmap" << LastMap;
+	QDialogButtonBox* ButtonBox = new QDialogButtonBox(&Dialog);
+	ButtonBox->setOrientation(Qt::Horizontal);
+	ButtonBox->setStandardButtons(QDialogButtonBox::Cancel);
+	ButtonBox->addButton("Build", QDialogButtonBox::AcceptRole);
+	ButtonBox->setCenterButtons(true);
 
-		QString ExtraOptions = mRunOptionsWidget->text();
-		if (!ExtraOptions.isEmpty())
-			Args << ExtraOptions.split(' ');
+	Layout->addWidget(ButtonBox);
 
-		Commands.append(QPair<QString, QStringList>(QString("%1/BlackOps3.exe").arg(mGamePath), Args));
-	}
+	connect(ButtonBox, SIGNAL(accepted()), &Dialog, SLOT(accept()));
+	connect(ButtonBox, SIGNAL(rejected()), &Dialog, SLOT(reject()));
 
-	if (Commands.size() == 0 && !UpdateAdded)
-	{
-		QMessageBox::information(this, "No Tasks", "Please selected at least one file from the list and one action to be performed.");
+	if (Dialog.exec() != QDialog::Accepted)
 		return;
-	}
 
-	StartBuildThread(Commands);
+	StartBuildThread(Graph, Options);
 }
 
 void mlMainWindow::OnEditPublish()
 {
-	std::function<QTreeWidgetItem* (QTreeWidgetItem*)> SearchCheckedItem=[&](QTreeWidgetItem* ParentItem) -> QTreeWidgetItem*
-	{
-		for (int ChildIdx = 0; ChildIdx < ParentItem->childCount(); ChildIdx++)
-		{
-			QTreeWidgetItem* Child = ParentItem->child(ChildIdx);
-			if (Child->checkState(0) == Qt::Checked)
-				return Child;
-
-			QTreeWidgetItem* Checked = SearchCheckedItem(Child);
-			if (Checked)
-				return Checked;
-		}
-
-		return nullptr;
-	};
-
-	QTreeWidgetItem* Item = SearchCheckedItem(mFileListWidget->invisibleRootItem());
-	if (!Item)
+	QList<mlBuildItem> Items = mFileListModel->CheckedItems();
+	if (Items.isEmpty())
 	{
 		QMessageBox::warning(this, "Error", "No maps or mods checked.");
 		return;
 	}
 
+	const mlBuildItem& Item = Items[0];
 	QString Folder;
-	if (Item->data(0, Qt::UserRole).toInt() == ML_ITEM_MAP)
+	if (Item.Type == ML_ITEM_MAP)
 	{
-		Folder = "usermaps/" + Item->text(0);
+		Folder = "usermaps/" + Item.Name;
 		mType = "map";
-		mFolderName = Item->text(0);
+		mFolderName = Item.Name;
 	}
 	else
 	{
-		Folder = "mods/" + Item->parent()->text(0);
+		Folder = "mods/" + Item.Name;
 		mType = "mod";
-		mFolderName = Item->parent()->text(0);
+		mFolderName = Item.Name;
 	}
 
 	mWorkshopFolder = QString("%1/%2/zone").arg(mGamePath, Folder);
@@ -1155,6 +1312,71 @@ void mlMainWindow::OnEditOptions()
 
 	Layout->addLayout(LanguageLayout);
 
+	QHBoxLayout* JobsLayout = new QHBoxLayout();
+	JobsLayout->addWidget(new QLabel("Build Jobs:"));
+
+	QSpinBox* JobsSpinBox = new QSpinBox();
+	JobsSpinBox->setToolTip("Maximum number of build steps that can run at the same time");
+	JobsSpinBox->setRange(1, qMax(QThread::idealThreadCount(), 1) * 2);
+	JobsSpinBox->setValue(mBuildJobs);
+	JobsLayout->addWidget(JobsSpinBox);
+
+	Layout->addLayout(JobsLayout);
+
+	QHBoxLayout* ConvertJobsLayout = new QHBoxLayout();
+	ConvertJobsLayout->addWidget(new QLabel("Export2Bin Jobs:"));
+
+	QSpinBox* ConvertJobsSpinBox = new QSpinBox();
+	ConvertJobsSpinBox->setToolTip("Maximum number of files converted by Export2Bin at the same time");
+	ConvertJobsSpinBox->setRange(1, qMax(QThread::idealThreadCount(), 1) * 2);
+	ConvertJobsSpinBox->setValue(mConvertJobs);
+	ConvertJobsLayout->addWidget(ConvertJobsSpinBox);
+
+	Layout->addLayout(ConvertJobsLayout);
+
+	QHBoxLayout* MemoryLayout = new QHBoxLayout();
+	MemoryLayout->addWidget(new QLabel("Memory Budget (GB):"));
+
+	QSpinBox* MemorySpinBox = new QSpinBox();
+	MemorySpinBox->setToolTip("Build steps wait for running steps to finish when the memory they used last time would not fit in this budget");
+	MemorySpinBox->setRange(0, 1024);
+	MemorySpinBox->setSpecialValueText("No Limit");
+	MemorySpinBox->setValue(mMemoryBudget);
+	MemoryLayout->addWidget(MemorySpinBox);
+
+	Layout->addLayout(MemoryLayout);
+
+	QHBoxLayout* CacheDirLayout = new QHBoxLayout();
+	CacheDirLayout->addWidget(new QLabel("Artifact Cache:"));
+
+	QLineEdit* CacheDirEdit = new QLineEdit(mArtifactCacheDir);
+	CacheDirEdit->setToolTip("Folder where compiled and linked outputs are shared between checkouts and users, leave empty to disable");
+	CacheDirLayout->addWidget(CacheDirEdit);
+
+	QToolButton* CacheDirButton = new QToolButton();
+	CacheDirButton->setText("...");
+	CacheDirLayout->addWidget(CacheDirButton);
+
+	connect(CacheDirButton, &QToolButton::clicked, [&]()
+	{
+		QString Folder = QFileDialog::getExistingDirectory(&Dialog, "Artifact Cache Folder", CacheDirEdit->text());
+		if (!Folder.isEmpty())
+			CacheDirEdit->setText(Folder);
+	});
+
+	Layout->addLayout(CacheDirLayout);
+
+	QHBoxLayout* CacheSizeLayout = new QHBoxLayout();
+	CacheSizeLayout->addWidget(new QLabel("Artifact Cache Size (GB):"));
+
+	QSpinBox* CacheSizeSpinBox = new QSpinBox();
+	CacheSizeSpinBox->setToolTip("The least recently used outputs are removed when the cache grows past this size");
+	CacheSizeSpinBox->setRange(1, 10000);
+	CacheSizeSpinBox->setValue(mArtifactCacheSize);
+	CacheSizeLayout->addWidget(CacheSizeSpinBox);
+
+	Layout->addLayout(CacheSizeLayout);
+
 	QDialogButtonBox* ButtonBox = new QDialogButtonBox(&Dialog);
 	ButtonBox->setOrientation(Qt::Horizontal);
 	ButtonBox->setStandardButtons(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
@@ -1169,14 +1391,108 @@ void mlMainWindow::OnEditOptions()
 		return;
 
 	mBuildLanguage = LanguageCombo->currentText();
+	mBuildJobs = JobsSpinBox->value();
+	mConvertJobs = ConvertJobsSpinBox->value();
+	mMemoryBudget = MemorySpinBox->value();
+	mArtifactCacheDir = CacheDirEdit->text();
+	mArtifactCacheSize = CacheSizeSpinBox->value();
 	mTreyarchTheme = Checkbox->isChecked();
 
 	Settings.setValue("BuildLanguage", mBuildLanguage);
+	Settings.setValue("BuildJobs", mBuildJobs);
+	Settings.setValue("ConvertJobs", mConvertJobs);
+	Settings.setValue("MemoryBudget", mMemoryBudget);
+	Settings.setValue("ArtifactCacheDir", mArtifactCacheDir);
+	Settings.setValue("ArtifactCacheSize", mArtifactCacheSize);
 	Settings.setValue("UseDarkTheme", mTreyarchTheme);
 
 	UpdateTheme();
 }
 
+void mlMainWindow::OnEditBuildProfiles()
+{
+	QDialog Dialog(this, Qt::WindowTitleHint | Qt::WindowSystemMenuHint | Qt::WindowCloseButtonHint);
+	Dialog.setWindowTitle("Build Profiles");
+	Dialog.resize(800, 400);
+
+	QVBoxLayout* Layout = new QVBoxLayout(&Dialog);
+	Layout->addWidget(new QLabel("Resources used by each build step the last time it succeeded:"));
+
+	mlBuildProfiles Profiles(mlBuildProfiles::DefaultFileName(mToolsPath));
+	Profiles.Load();
+
+	QTableWidget* Table = new QTableWidget(&Dialog);
+	Table->setColumnCount(7);
+	Table->setHorizontalHeaderLabels(QStringList() << "Step" << "Tool" << "Peak Memory (MB)" << "CPU Time (s)" << "Duration (s)" << "Runs" << "Last Run");
+	Table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	Table->setSelectionBehavior(QAbstractItemView::SelectRows);
+	Table->verticalHeader()->hide();
+	Table->horizontalHeader()->setStretchLastSection(true);
+	Layout->addWidget(Table);
+
+	auto FillTable = [&]() -> void
+	{
+		QList<mlBuildProfile> ProfileList = Profiles.Profiles();
+		Table->setSortingEnabled(false);
+		Table->setRowCount(ProfileList.count());
+
+		for (int Row = 0; Row < ProfileList.count(); Row++)
+		{
+			const mlBuildProfile& Profile = ProfileList[Row];
+
+			QTableWidgetItem* NameItem = new QTableWidgetItem(Profile.Name);
+			NameItem->setToolTip(Profile.Arguments);
+			Table->setItem(Row, 0, NameItem);
+			Table->setItem(Row, 1, new QTableWidgetItem(Profile.Tool));
+
+			// Numbers are stored as numbers so the columns sort by value
+			QTableWidgetItem* MemoryItem = new QTableWidgetItem();
+			MemoryItem->setData(Qt::DisplayRole, Profile.PeakMemory / (1024 * 1024));
+			Table->setItem(Row, 2, MemoryItem);
+
+			QTableWidgetItem* CPUItem = new QTableWidgetItem();
+			CPUItem->setData(Qt::DisplayRole, qRound((Profile.UserTime + Profile.SystemTime) / 100.0) / 10.0);
+			Table->setItem(Row, 3, CPUItem);
+
+			QTableWidgetItem* DurationItem = new QTableWidgetItem();
+			DurationItem->setData(Qt::DisplayRole, qRound(Profile.Duration / 100.0) / 10.0);
+			Table->setItem(Row, 4, DurationItem);
+
+			QTableWidgetItem* RunsItem = new QTableWidgetItem();
+			RunsItem->setData(Qt::DisplayRole, Profile.Runs);
+			Table->setItem(Row, 5, RunsItem);
+
+			Table->setItem(Row, 6, new QTableWidgetItem(Profile.LastRun.toString(Qt::SystemLocaleShortDate)));
+		}
+
+		Table->setSortingEnabled(true);
+		Table->sortByColumn(2, Qt::DescendingOrder);
+		Table->resizeColumnsToContents();
+	};
+
+	FillTable();
+
+	QDialogButtonBox* ButtonBox = new QDialogButtonBox(&Dialog);
+	ButtonBox->setOrientation(Qt::Horizontal);
+	ButtonBox->setStandardButtons(QDialogButtonBox::Close);
+	QPushButton* ClearButton = ButtonBox->addButton("Clear", QDialogButtonBox::ResetRole);
+
+	Layout->addWidget(ButtonBox);
+
+	connect(ButtonBox, SIGNAL(rejected()), &Dialog, SLOT(reject()));
+	connect(ClearButton, &QPushButton::clicked, [&]()
+	{
+		if (QMessageBox::question(&Dialog, "Clear Build Profiles", "Forget the resources used by all build steps?") != QMessageBox::Yes)
+			return;
+
+		Profiles.Clear();
+		Profiles.Save();
+		FillTable();
+	});
+
+	Dialog.exec();
+}
+
 void mlMainWindow::UpdateTheme()
 {
 	if (mTreyarchTheme)
@@ -1418,53 +1734,47 @@ void mlMainWindow::OnHelpAbout()
 
 void mlMainWindow::OnOpenZoneFile()
 {
-	QList<QTreeWidgetItem*> ItemList = mFileListWidget->selectedItems();
-	if (ItemList.isEmpty())
+	mlBuildItem Item = SelectedFileListItem();
+	if (Item.Name.isEmpty())
 		return;
-	
-	QTreeWidgetItem* Item = ItemList[0];
 
-	if (Item->data(0, Qt::UserRole).toInt() == ML_ITEM_MAP)
+	if (Item.Type == ML_ITEM_MAP)
 	{
-		QString MapName = Item->text(0);
+		QString MapName = Item.Name;
 		ShellExecute(NULL, "open", QString("\"%1/usermaps/%2/zone_source/%3.zone\"").arg(mGamePath, MapName, MapName).toLatin1().constData(), "", NULL, SW_SHOWDEFAULT);
 	}
 	else
 	{
-		QString ModName = Item->parent()->text(0);
-		QString ZoneName = Item->text(0);
+		QString ModName = Item.Name;
+		QString ZoneName = Item.Zone;
 		ShellExecute(NULL, "open", (QString("\"%1/mods/%2/zone_source/%3.zone\"").arg(mGamePath, ModName, ZoneName)).toLatin1().constData(), "", NULL, SW_SHOWDEFAULT);
 	}
 }
 
 void mlMainWindow::OnOpenModRootFolder()
 {
-	QList<QTreeWidgetItem*> ItemList = mFileListWidget->selectedItems();
-	if (ItemList.isEmpty())
+	mlBuildItem Item = SelectedFileListItem();
+	if (Item.Name.isEmpty())
 		return;
 
-	QTreeWidgetItem* Item = ItemList[0];
-
-	if (Item->data(0, Qt::UserRole).toInt() == ML_ITEM_MAP)
+	if (Item.Type == ML_ITEM_MAP)
 	{
-		QString MapName = Item->text(0);
+		QString MapName = Item.Name;
 		ShellExecute(NULL, "open", (QString("\"%1/usermaps/%2\"").arg(mGamePath, MapName)).toLatin1().constData(), "", NULL, SW_SHOWDEFAULT);
 	}
 	else
 	{
-		QString ModName = Item->parent() ? Item->parent()->text(0) : Item->text(0);
+		QString ModName = Item.Name;
 		ShellExecute(NULL, "open", (QString("\"%1/mods/%2\"").arg(mGamePath, ModName)).toLatin1().constData(), "", NULL, SW_SHOWDEFAULT);
 	}
 }
 
 void mlMainWindow::OnRunMapOrMod()
 {
-	QList<QTreeWidgetItem*> ItemList = mFileListWidget->selectedItems();
-	if (ItemList.isEmpty())
+	mlBuildItem Item = SelectedFileListItem();
+	if (Item.Name.isEmpty())
 		return;
 
-	QTreeWidgetItem* Item = ItemList[0];
-
 	QStringList Args;
 
 	if(!mRunDvars.isEmpty())
@@ -1472,15 +1782,15 @@ void mlMainWindow::OnRunMapOrMod()
 
 	Args << "+set" << "fs_game";
 
-	if (Item->data(0, Qt::UserRole).toInt() == ML_ITEM_MAP)
+	if (Item.Type == ML_ITEM_MAP)
 	{
-		QString MapName = Item->text(0);
+		QString MapName = Item.Name;
 		Args << MapName;
 		Args << "+devmap" << MapName;
 	}
 	else
 	{
-		QString ModName = Item->parent() ? Item->parent()->text(0) : Item->text(0);
+		QString ModName = Item.Name;
 		Args << ModName;
 	}
 
@@ -1488,12 +1798,12 @@ void mlMainWindow::OnRunMapOrMod()
 	if (!ExtraOptions.isEmpty())
 		Args << ExtraOptions.split(' ');
 
-	QList<QPair<QString, QStringList>> Commands;
-	Commands.append(QPair<QString, QStringList>(QString("%1/BlackOps3.exe").arg(mGamePath), Args));
-	StartBuildThread(Commands);
+	mlBuildGraph Graph;
+	Graph.AddStep("run", QString("%1/BlackOps3.exe").arg(mGamePath), Args);
+	StartBuildThread(Graph, BuildOptions());
 }
 
-void mlMainWindow::OnSaveLog() const
+void mlMainWindow::OnSaveLog()
 {
 	// want to make a logs directory for easy management of launcher logs (exe_dir/logs)
 	const auto dir = QDir{};
@@ -1518,32 +1828,66 @@ void mlMainWindow::OnSaveLog() const
 
 	QFile log(QString{ "logs/modlog_%1.txt" }.arg(dateStr.c_str()));
 
-	if (!log.open(QIODevice::WriteOnly))
-		return;
+	// The session logs already hold everything, including what scrolled out of the output window. The writers can still
+	// be holding some output, and a conversion started during a build shares the window, so both logs are merged.
+	mBuildLog.Flush();
+	mConvertLog.Flush();
 
-	QTextStream stream(&log);
-	stream << mOutputWidget->toPlainText();
+	bool merged = !mWindowSessionLogs.isEmpty() && log.open(QIODevice::WriteOnly);
+	for (const QString& sessionLog : mWindowSessionLogs)
+	{
+		QFile session(sessionLog);
+		if (!merged || !session.open(QIODevice::ReadOnly))
+		{
+			merged = false;
+			break;
+		}
+
+		while (merged && !session.atEnd())
+		{
+			const QByteArray data = session.read(1024 * 1024);
+			merged = log.write(data) == data.size();
+		}
+	}
+
+	if (!merged)
+	{
+		log.close();
+		if (!log.open(QIODevice::WriteOnly))
+			return;
+
+		QTextStream stream(&log);
+		stream << mOutputWidget->toPlainText();
+	}
+	log.close();
+
+	// The timeline of the last build can be opened in chrome://tracing or Perfetto
+	QString traceFileName = QString{ "logs/modlog_%1.json" }.arg(dateStr.c_str());
+	if (!mLastTrace.IsEmpty() && mLastTrace.Export(traceFileName))
+	{
+		QMessageBox::information(nullptr, QString("Save Log"), QString("The console log has been saved to %1 and the build timeline to %2").arg(log.fileName(), traceFileName));
+		return;
+	}
 
 	QMessageBox::information(nullptr, QString("Save Log"), QString("The console log has been saved to %1").arg(log.fileName()));
 }
 
 void mlMainWindow::OnCleanXPaks()
 {
-	QList<QTreeWidgetItem*> ItemList = mFileListWidget->selectedItems();
-	if (ItemList.isEmpty())
+	mlBuildItem Item = SelectedFileListItem();
+	if (Item.Name.isEmpty())
 		return;
 
-	QTreeWidgetItem* Item = ItemList[0];
 	QString Folder;
 
-	if (Item->data(0, Qt::UserRole).toInt() == ML_ITEM_MAP)
+	if (Item.Type == ML_ITEM_MAP)
 	{
-		QString MapName = Item->text(0);
+		QString MapName = Item.Name;
 		Folder = QString("%1/usermaps/%2").arg(mGamePath, MapName);
 	}
 	else
 	{
-		QString ModName = Item->parent() ? Item->parent()->text(0) : Item->text(0);
+		QString ModName = Item.Name;
 		Folder = QString("%1/mods/%2").arg(mGamePath, ModName);
 	}
 
@@ -1577,21 +1921,20 @@ void mlMainWindow::OnCleanXPaks()
 
 void mlMainWindow::OnDelete()
 {
-	QList<QTreeWidgetItem*> ItemList = mFileListWidget->selectedItems();
-	if (ItemList.isEmpty())
+	mlBuildItem Item = SelectedFileListItem();
+	if (Item.Name.isEmpty())
 		return;
 
-	QTreeWidgetItem* Item = ItemList[0];
 	QString Folder;
 
-	if (Item->data(0, Qt::UserRole).toInt() == ML_ITEM_MAP)
+	if (Item.Type == ML_ITEM_MAP)
 	{
-		QString MapName = Item->text(0);
+		QString MapName = Item.Name;
 		Folder = QString("%1/usermaps/%2").arg(mGamePath, MapName);
 	}
 	else
 	{
-		QString ModName = Item->parent() ? Item->parent()->text(0) : Item->text(0);
+		QString ModName = Item.Name;
 		Folder = QString("%1/mods/%2").arg(mGamePath, ModName);
 	}
 
@@ -1611,22 +1954,275 @@ void mlMainWindow::OnExport2BinChooseDirectory()
 	Settings.setValue("Export2Bin_TargetDir", dir);
 }
 
-void mlMainWindow::OnExport2BinToggleOverwriteFiles()
+void mlMainWindow::OnExport2BinChooseWatchDirectory()
+{
+	const QString dir = QFileDialog::getExistingDirectory(mExport2BinGUIWidget, tr("Watch Directory"), mExport2BinWatchDirWidget->text(), QFileDialog::ShowDirsOnly | QFileDialog::DontResolveSymlinks);
+	if (dir.isEmpty())
+		return;
+
+	mExport2BinWatchDirWidget->setText(dir);
+	OnExport2BinToggleWatch();
+}
+
+void mlMainWindow::OnExport2BinToggleWatch()
+{
+	QSettings Settings;
+	Settings.setValue("Export2Bin_WatchDir", mExport2BinWatchDirWidget->text());
+
+	if (!mExport2BinWatcher.directories().isEmpty())
+		mExport2BinWatcher.removePaths(mExport2BinWatcher.directories());
+	mExport2BinWatchTimer.stop();
+	mExport2BinChangedDirs.clear();
+	mExport2BinWatchFiles.clear();
+
+	if (!mExport2BinWatchWidget->isChecked())
+		return;
+
+	QString WatchDir = QDir::cleanPath(mExport2BinWatchDirWidget->text());
+	if (!QFileInfo(WatchDir).isDir())
+	{
+		ConvertOutputReady(QString("Export2Bin: Watch folder '%1' does not exist\n").arg(WatchDir));
+		mExport2BinWatchWidget->setChecked(false);
+		return;
+	}
+
+	// The first scan only records what is already there, files are converted once they change
+	ScanExport2BinWatchDirectory(WatchDir);
+	ConvertOutputReady(QString("Export2Bin: Watching '%1' (%2 folders)\n").arg(WatchDir).arg(mExport2BinWatcher.directories().count()));
+}
+
+void mlMainWindow::OnExport2BinWatchDirectoryChanged(const QString& Path)
+{
+	mExport2BinChangedDirs.insert(Path);
+	mExport2BinWatchTimer.start();
+}
+
+void mlMainWindow::OnExport2BinWatchTimeout()
+{
+	for (const QString& Dir : mExport2BinChangedDirs)
+	{
+		if (!QFileInfo(Dir).isDir())
+		{
+			mExport2BinWatcher.removePath(Dir);
+			continue;
+		}
+
+		for (const QString& File : ScanExport2BinWatchDirectory(Dir))
+			if (!mExport2BinQueue.contains(File))
+				mExport2BinQueue.append(File);
+	}
+
+	mExport2BinChangedDirs.clear();
+
+	if (mExport2BinQueue.isEmpty() || mConvertThread)
+		return;
+
+	// Only the files that changed are queued, the manifest still skips exports that were saved again without changes
+	QStringList Files = mExport2BinQueue;
+	QString OutputDir = mExport2BinTargetDirWidget->text();
+	mExport2BinQueue.clear();
+	StartConvertThread(Files, OutputDir, ML_OVERWRITE_CHANGED);
+}
+
+// Returns the exports in a watched folder that are new or were modified since it was last scanned, subfolders that
+// are not watched yet are added to the watcher and scanned as well
+QStringList mlMainWindow::ScanExport2BinWatchDirectory(const QString& Path)
+{
+	QStringList ChangedFiles;
+	QDir Dir(Path);
+
+	if (!mExport2BinWatcher.directories().contains(Path))
+		mExport2BinWatcher.addPath(Path);
+
+	for (const QFileInfo& FileInfo : Dir.entryInfoList(QStringList() << "*.xmodel_export" << "*.xanim_export", QDir::Files))
+	{
+		QString FilePath = FileInfo.absoluteFilePath();
+		qint64 Modified = FileInfo.lastModified().toMSecsSinceEpoch();
+
+		QHash<QString, qint64>::iterator It = mExport2BinWatchFiles.find(FilePath);
+		if (It != mExport2BinWatchFiles.end() && It.value() == Modified)
+			continue;
+
+		mExport2BinWatchFiles.insert(FilePath, Modified);
+		ChangedFiles << FilePath;
+	}
+
+	for (const QFileInfo& SubDirInfo : Dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot))
+	{
+		QString SubDir = QDir::cleanPath(SubDirInfo.absoluteFilePath());
+		if (!mExport2BinWatcher.directories().contains(SubDir))
+			ChangedFiles << ScanExport2BinWatchDirectory(SubDir);
+	}
+
+	return ChangedFiles;
+}
+
+void mlMainWindow::OnExport2BinOverwriteModeChanged()
 {
 	QSettings Settings;
-	Settings.setValue("Export2Bin_OverwriteFiles", mExport2BinOverwriteWidget->isChecked());
+	Settings.setValue("Export2Bin_OverwriteMode", mExport2BinOverwriteWidget->currentIndex());
 }
 
 void mlMainWindow::BuildOutputReady(QString Output)
 {
-	mOutputWidget->appendPlainText(Output);
+	mBuildLog.Write(Output);
+	mOutputWidget->AppendOutput(Output);
+}
+
+void mlMainWindow::ConvertOutputReady(QString Output)
+{
+	mConvertLog.Write(Output);
+	mOutputWidget->AppendOutput(Output);
+}
+
+void mlMainWindow::DiagnosticsUpdated(int ErrorCount, int WarningCount)
+{
+	mDiagnosticsLabel->setText(QString("%1 error(s), %2 warning(s)").arg(ErrorCount).arg(WarningCount));
+	mNextErrorButton->setEnabled(ErrorCount > 0);
+}
+
+// Searches forward from the cursor and wraps around to the start of the log
+void mlMainWindow::OnNextError()
+{
+	QRegExp ErrorExp(mlDiagnosticParser::ErrorPattern(), Qt::CaseInsensitive);
+
+	if (mOutputWidget->find(ErrorExp))
+		return;
+
+	mOutputWidget->moveCursor(QTextCursor::Start);
+	mOutputWidget->find(ErrorExp);
+}
+
+void mlMainWindow::BuildProgressUpdated(int Percent, int RemainingSeconds)
+{
+	mProgressWidget->setValue(Percent);
+
+	if (RemainingSeconds >= 0)
+		mRemainingTimeLabel->setText(QString("About %1 left").arg(FormatDuration((qint64)RemainingSeconds * 1000)));
+	else
+		mRemainingTimeLabel->clear();
 }
 
 void mlMainWindow::BuildFinished()
 {
+	mLastTrace = mBuildThread->Trace();
+
 	mBuildButton->setText("Build");
 	mBuildThread->deleteLater();
 	mBuildThread = NULL;
+
+	mPlanButton->setEnabled(true);
+	mProgressWidget->hide();
+	mRemainingTimeLabel->clear();
+
+	mBuildLog.Close();
+}
+
+void mlMainWindow::ConvertStarted(int FileCount, int TotalKB)
+{
+	mExport2BinFileCount = FileCount;
+	mExport2BinFilesDone = 0;
+	mExport2BinTotalKB = TotalKB;
+	mExport2BinDoneKB = 0;
+	mExport2BinConvertedKB = 0;
+	mExport2BinTimer.start();
+
+	if (!mExport2BinGUIWidget)
+		return;
+
+	mExport2BinProgressWidget->setRange(0, qMax(FileCount, 1));
+	mExport2BinProgressWidget->setValue(0);
+	mExport2BinRateLabel->clear();
+	mExport2BinStatsWidget->setRowCount(0);
+}
+
+// Rates only count the files that were converted, the time left is estimated from the size of the files still to go
+void mlMainWindow::ConvertFileFinished(const QString& File, int Status, int ExitCode, int InputKB, int OutputKB, int Milliseconds, const QString& Assets)
+{
+	mExport2BinFilesDone++;
+	mExport2BinDoneKB += InputKB;
+	if (Status == ML_CONVERT_SUCCEEDED || Status == ML_CONVERT_FAILED)
+		mExport2BinConvertedKB += InputKB;
+
+	if (!mExport2BinGUIWidget)
+		return;
+
+	const char* StatusNames[] = { "Succeeded", "Failed", "Skipped", "Unchanged" };
+	double Seconds = qMax(mExport2BinTimer.elapsed(), (qint64)1) / 1000.0;
+
+	QString Rate = QString("%1 of %2 files, %3 files/s, %4 MB/s").arg(mExport2BinFilesDone).arg(mExport2BinFileCount).arg(mExport2BinFilesDone / Seconds, 0, 'f', 1)
+		.arg(mExport2BinConvertedKB / 1024.0 / Seconds, 0, 'f', 1);
+	if (mExport2BinDoneKB > 0 && mExport2BinFilesDone < mExport2BinFileCount)
+		Rate += QString(", about %1 left").arg(FormatDuration((qint64)((mExport2BinTotalKB - mExport2BinDoneKB) * Seconds * 1000 / mExport2BinDoneKB)));
+
+	mExport2BinProgressWidget->setValue(mExport2BinFilesDone);
+	mExport2BinRateLabel->setText(Rate);
+
+	// Sorting is turned off while the row is filled in, otherwise the row moves after its first cell is set
+	mExport2BinStatsWidget->setSortingEnabled(false);
+
+	int Row = mExport2BinStatsWidget->rowCount();
+	mExport2BinStatsWidget->insertRow(Row);
+
+	QTableWidgetItem* FileItem = new QTableWidgetItem(QFileInfo(File).fileName());
+	FileItem->setToolTip(File);
+	FileItem->setData(Qt::UserRole, File);
+	mExport2BinStatsWidget->setItem(Row, 0, FileItem);
+	mExport2BinStatsWidget->setItem(Row, 1, new QTableWidgetItem(StatusNames[qBound(0, Status, 3)]));
+
+	int Values[] = { ExitCode, Milliseconds, InputKB, OutputKB };
+	for (int ValueIdx = 0; ValueIdx < 4; ValueIdx++)
+	{
+		QTableWidgetItem* Item = new QTableWidgetItem();
+		Item->setData(Qt::DisplayRole, Values[ValueIdx]);
+		mExport2BinStatsWidget->setItem(Row, ValueIdx + 2, Item);
+	}
+
+	mExport2BinStatsWidget->setItem(Row, 6, new QTableWidgetItem(Assets));
+
+	mExport2BinStatsWidget->setSortingEnabled(true);
+}
+
+void mlMainWindow::OnExport2BinExportStats()
+{
+	QString FileName = QFileDialog::getSaveFileName(mExport2BinGUIWidget, "Export Export2Bin Stats", "export2bin_stats.csv", "CSV Files (*.csv)");
+	if (FileName.isEmpty())
+		return;
+
+	QFile File(FileName);
+	if (!File.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		QMessageBox::warning(this, "Error", QString("Could not open '%1' for writing.").arg(FileName));
+		return;
+	}
+
+	QTextStream Stream(&File);
+	Stream << "File,Status,Exit Code,Time (ms),In (KB),Out (KB),Assets\n";
+
+	for (int Row = 0; Row < mExport2BinStatsWidget->rowCount(); Row++)
+	{
+		QString Path = mExport2BinStatsWidget->item(Row, 0)->data(Qt::UserRole).toString();
+		Stream << '"' << Path.replace('"', "\"\"") << '"';
+
+		for (int Column = 1; Column < mExport2BinStatsWidget->columnCount(); Column++)
+			Stream << ",\"" << mExport2BinStatsWidget->item(Row, Column)->text() << '"';
+
+		Stream << '\n';
+	}
+}
+
+void mlMainWindow::ConvertFinished()
+{
+	mLastTrace = mConvertThread->Trace();
+
+	mConvertThread->deleteLater();
+	mConvertThread = NULL;
+
+	mConvertLog.Close();
+
+	// Exports that changed in the watch folder while converting
+	if (!mExport2BinQueue.isEmpty())
+		OnExport2BinWatchTimeout();
 }
 
 Export2BinGroupBox::Export2BinGroupBox(QWidget* parent, mlMainWindow* parent_window) : QGroupBox(parent), parentWindow(parent_window)
@@ -1648,6 +2244,14 @@ void Export2BinGroupBox::dropEvent(QDropEvent* event)
 		return;
 	}
 
+	// Only one conversion runs at a time, the drop is refused rather than converted later with a different overwrite mode
+	if (parentWindow->mConvertThread)
+	{
+		parentWindow->ConvertOutputReady("Export2Bin: A conversion is already running, drop the files again once it has finished\n");
+		event->ignore();
+		return;
+	}
+
 	if (mimeData->hasUrls())
 	{
 		QStringList pathList;
@@ -1662,10 +2266,10 @@ void Export2BinGroupBox::dropEvent(QDropEvent* event)
 		QProcess* Process = new QProcess();
 		connect(Process, SIGNAL(finished(int)), Process, SLOT(deleteLater()));
 
-		bool allowOverwrite = this->parentWindow->mExport2BinOverwriteWidget->isChecked();
+		mlOverwriteMode overwriteMode = (mlOverwriteMode)this->parentWindow->mExport2BinOverwriteWidget->currentIndex();
 
 		QString outputDir = parentWindow->mExport2BinTargetDirWidget->text();
-		parentWindow->StartConvertThread(pathList, outputDir, allowOverwrite);
+		parentWindow->StartConvertThread(pathList, outputDir, overwriteMode);
 		
 		event->acceptProposedAction();
 	}
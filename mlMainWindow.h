@@ -18,61 +18,34 @@
 
 #pragma once
 
-class mlBuildThread : public QThread
+// Finds the maps and mods in the game folder, the folders are checked in parallel and reported in name order as they are found
+class mlFileScanThread : public QThread
 {
 	Q_OBJECT
 
 public:
-	mlBuildThread(const QList<QPair<QString, QStringList>>& Commands, bool IgnoreErrors);
+	mlFileScanThread(const QString& GamePath, const QString& IndexFileName);
 	void run();
-	bool Succeeded() const
-	{
-		return mSuccess;
-	}
 
 	void Cancel()
 	{
 		mCancel = true;
 	}
 
-signals:
-	void OutputReady(const QString& Output);
-
-protected:
-	QList<QPair<QString, QStringList>> mCommands;
-	bool mSuccess;
-	bool mCancel;
-	bool mIgnoreErrors;
-};
-
-class mlConvertThread : public QThread
-{
-	Q_OBJECT
-
-public:
-	mlConvertThread(QStringList& Files, QString& OutputDir, bool IgnoreErrors, bool mOverwrite);
-	void run();
-	bool Succeeded() const
-	{
-		return mSuccess;
-	}
-
-	void Cancel()
+	// Folders whose changes can add or remove items, only valid once the thread has finished
+	const QStringList& WatchPaths() const
 	{
-		mCancel = true;
+		return mWatchPaths;
 	}
 
 signals:
-	void OutputReady(const QString& Output);
+	void ItemFound(int Type, const QString& Name, const QStringList& Zones);
 
 protected:
-	QStringList mFiles;
-	QString mOutputDir;
-	bool mOverwrite;
-
-	bool mSuccess;
-	bool mCancel;
-	bool mIgnoreErrors;
+	QString mGamePath;
+	QString mIndexFileName;
+	QStringList mWatchPaths;
+	volatile bool mCancel;
 };
 
 class mlMainWindow : public QMainWindow
@@ -102,30 +75,51 @@ protected slots:
 	void OnFileLevelEditor();
 	void OnFileExport2Bin();
 	void OnEditBuild();
+	void OnEditPlan();
 	void OnEditPublish();
 	void OnEditOptions();
+	void OnEditBuildProfiles();
 	void OnEditDvars();
 	void OnHelpAbout();
 	void OnOpenZoneFile();
 	void OnOpenModRootFolder();
 	void OnRunMapOrMod();
-	void OnSaveLog() const;
+	void OnSaveLog();
 	void OnCleanXPaks();
 	void OnDelete();
 	void OnExport2BinChooseDirectory();
-	void OnExport2BinToggleOverwriteFiles();
+	void OnExport2BinOverwriteModeChanged();
+	void OnExport2BinChooseWatchDirectory();
+	void OnExport2BinToggleWatch();
+	void OnExport2BinWatchDirectoryChanged(const QString& Path);
+	void OnExport2BinWatchTimeout();
+	void OnExport2BinExportStats();
+	void ConvertStarted(int FileCount, int TotalKB);
+	void ConvertFileFinished(const QString& File, int Status, int ExitCode, int InputKB, int OutputKB, int Milliseconds, const QString& Assets);
 	void BuildOutputReady(QString Output);
+	void ConvertOutputReady(QString Output);
+	void DiagnosticsUpdated(int ErrorCount, int WarningCount);
+	void OnNextError();
+	void BuildProgressUpdated(int Percent, int RemainingSeconds);
 	void BuildFinished();
+	void ConvertFinished();
+	void PopulateFileList();
+	void FileScanItemFound(int Type, const QString& Name, const QStringList& Zones);
+	void FileScanFinished();
 	void ContextMenuRequested();
+	void OnFileListFilterChanged();
 	void SteamUpdate();
 
 protected:
 	void closeEvent(QCloseEvent* Event);
 
-	void StartBuildThread(const QList<QPair<QString, QStringList>>& Commands);
-	void mlMainWindow::StartConvertThread(QStringList& pathList, QString& outputDir, bool allowOverwrite);
+	mlBuildOptions BuildOptions() const;
+	QList<mlBuildItem> CheckedBuildItems() const;
+	void StartBuildThread(const mlBuildGraph& Graph, const mlBuildOptions& Options);
+	void StartSessionLog(mlLogWriter& SessionLog);
+	void mlMainWindow::StartConvertThread(QStringList& pathList, QString& outputDir, mlOverwriteMode overwriteMode);
 
-	void PopulateFileList();
+	mlBuildItem SelectedFileListItem() const;
 	void UpdateWorkshopItem();
 	void ShowPublishDialog();
 	void UpdateTheme();
@@ -135,6 +129,7 @@ protected:
 	void CreateToolBar();
 
 	void InitExport2BinGUI();
+	QStringList ScanExport2BinWatchDirectory(const QString& Path);
 
 	QAction* mActionFileNew;
 	QAction* mActionFileAssetEditor;
@@ -142,14 +137,27 @@ protected:
 	QAction* mActionFileExport2Bin;
 	QAction* mActionFileExit;
 	QAction* mActionEditBuild;
+	QAction* mActionEditPlan;
 	QAction* mActionEditPublish;
 	QAction* mActionEditOptions;
+	QAction* mActionEditBuildProfiles;
 	QAction* mActionHelpAbout;
 
-	QTreeWidget* mFileListWidget;
-	QPlainTextEdit* mOutputWidget;
+	QTreeView* mFileListWidget;
+	QLineEdit* mFileListFilterWidget;
+	mlFileListModel* mFileListModel;
+	bool mFileListIndexLoaded;
+	QSet<QString> mStaleFileListItems;
+	mlFileScanThread* mFileScanThread;
+	bool mFileScanPending;
+	QFileSystemWatcher mFileListWatcher;
+	QTimer mFileListWatchTimer;
+	mlOutputWidget* mOutputWidget;
+	QProgressBar* mProgressWidget;
+	QLabel* mRemainingTimeLabel;
 
 	QPushButton* mBuildButton;
+	QPushButton* mPlanButton;
 	QPushButton* mDvarsButton;
 	QPushButton* mLogButton;
 	QCheckBox* mCompileEnabledWidget;
@@ -160,19 +168,50 @@ protected:
 	QCheckBox* mRunEnabledWidget;
 	QLineEdit* mRunOptionsWidget;
 	QCheckBox* mIgnoreErrorsWidget;
+	QCheckBox* mForceRebuildWidget;
+	QCheckBox* mForceUpdateDBWidget;
+	QCheckBox* mAbortOnFatalErrorWidget;
+	QLabel* mDiagnosticsLabel;
+	QPushButton* mNextErrorButton;
 
 	mlBuildThread* mBuildThread;
 	mlConvertThread* mConvertThread;
+	mlBuildTrace mLastTrace;
 
 	QDockWidget* mExport2BinGUIWidget;
-	QCheckBox* mExport2BinOverwriteWidget;
+	QComboBox* mExport2BinOverwriteWidget;
 	QLineEdit* mExport2BinTargetDirWidget;
+	QCheckBox* mExport2BinPreflightWidget;
+	QCheckBox* mExport2BinWatchWidget;
+	QLineEdit* mExport2BinWatchDirWidget;
+	QFileSystemWatcher mExport2BinWatcher;
+	QTimer mExport2BinWatchTimer;
+	QSet<QString> mExport2BinChangedDirs;
+	QHash<QString, qint64> mExport2BinWatchFiles;
+	QStringList mExport2BinQueue;
+	QProgressBar* mExport2BinProgressWidget;
+	QLabel* mExport2BinRateLabel;
+	QTableWidget* mExport2BinStatsWidget;
+	QElapsedTimer mExport2BinTimer;
+	int mExport2BinFileCount;
+	int mExport2BinFilesDone;
+	qint64 mExport2BinTotalKB;
+	qint64 mExport2BinDoneKB;
+	qint64 mExport2BinConvertedKB;
 
 	bool mTreyarchTheme;
 	QString mBuildLanguage;
+	int mBuildJobs;
+	int mConvertJobs;
+	QString mArtifactCacheDir;
+	int mArtifactCacheSize;
+	int mMemoryBudget;
 
 	QStringList mShippedMapList;
 	QTimer mTimer;
+	mlLogWriter mBuildLog;
+	mlLogWriter mConvertLog;
+	QStringList mWindowSessionLogs;
 
 	quint64 mFileId;
 	QString mTitle;
@@ -0,0 +1,58 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "stdafx.h"
+
+mlOutputWidget::mlOutputWidget(QWidget* Parent)
+	: QPlainTextEdit(Parent)
+{
+	setReadOnly(true);
+	setMaximumBlockCount(100000); // The full output is in the session log
+
+	mOutputTimer.setSingleShot(true);
+	mOutputTimer.setInterval(33);
+	connect(&mOutputTimer, &QTimer::timeout, this, [this]()
+	{
+		FlushOutput();
+	});
+}
+
+void mlOutputWidget::AppendOutput(const QString& Output)
+{
+	mPendingOutput.Append(Output);
+
+	if (!mOutputTimer.isActive())
+		mOutputTimer.start();
+}
+
+// A flood of output is appended a bounded amount at a time so the window stays responsive, the rest follows in the next frames
+void mlOutputWidget::FlushOutput()
+{
+	if (!mPendingOutput.IsEmpty())
+		appendPlainText(mPendingOutput.TakeFrame());
+
+	if (!mPendingOutput.IsEmpty())
+		mOutputTimer.start();
+}
+
+void mlOutputWidget::ClearOutput()
+{
+	clear();
+	mPendingOutput.Clear();
+	mOutputTimer.stop();
+}
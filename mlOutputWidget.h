@@ -0,0 +1,40 @@
+/*
+*
+* Copyright 2016 Activision Publishing, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+// The output window. Output is appended at most once per frame and a bounded amount at a time, appending every chunk as it
+// arrives keeps the UI thread busy laying out text while the tools print.
+class mlOutputWidget : public QPlainTextEdit
+{
+public:
+	mlOutputWidget(QWidget* Parent = NULL);
+
+	void AppendOutput(const QString& Output);
+	void FlushOutput();
+	void ClearOutput();
+
+	const mlOutputQueue& PendingOutput() const
+	{
+		return mPendingOutput;
+	}
+
+protected:
+	QTimer mOutputTimer;
+	mlOutputQueue mPendingOutput;
+};
@@ -18,9 +18,18 @@
 
 #pragma once
 
+// ML_CORE_ONLY leaves out the main window and the Steam SDK, see CMakeLists.txt
 #include <QtWidgets/QtWidgets>
+#ifndef ML_CORE_ONLY
 #include "steam_api.h"
 #include "dvar.h"
+#endif
+#include "mlCore.h"
+#include "mlOutputWidget.h"
+
+#ifndef ML_CORE_ONLY
+#include "mlFileListModel.h"
 
 class mlMainWindow;
 class mlExport2BinWidget;
+#endif